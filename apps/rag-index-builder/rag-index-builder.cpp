@@ -0,0 +1,141 @@
+// Compiles the RAG JSON knowledge base into the binary index that the module
+// maps at startup (OllamaChat.RAGIndexFile).
+//
+// Usage: rag-index-builder [options] <json directory> <index file>
+//   --title-boost <x>      default 2.0
+//   --keywords-boost <x>   default 1.5
+//   --tags-boost <x>       default 1.0
+//   --content-boost <x>    default 1.0
+//
+// The boosts must match the OllamaChat.RAG*Boost values in the worldserver
+// config, otherwise the worldserver ignores the index and loads the JSON.
+
+#include "mod-ollama-chat_rag_index.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static int Usage()
+{
+    std::cerr << "Usage: rag-index-builder [--title-boost x] [--keywords-boost x] [--tags-boost x] [--content-boost x]\n"
+                 "                         <json directory> <index file>\n";
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    RAGFieldBoosts boosts;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        float* boost = nullptr;
+        if (arg == "--title-boost") {
+            boost = &boosts.title;
+        } else if (arg == "--keywords-boost") {
+            boost = &boosts.keywords;
+        } else if (arg == "--tags-boost") {
+            boost = &boosts.tags;
+        } else if (arg == "--content-boost") {
+            boost = &boosts.content;
+        } else if (arg.rfind("--", 0) == 0) {
+            return Usage();
+        } else {
+            paths.push_back(arg);
+            continue;
+        }
+
+        if (++i >= argc) {
+            return Usage();
+        }
+        char* end = nullptr;
+        *boost = std::strtof(argv[i], &end);
+        if (end == argv[i] || *end != '\0') {
+            std::cerr << "Invalid value for " << arg << ": " << argv[i] << "\n";
+            return 2;
+        }
+    }
+    if (paths.size() != 2) {
+        return Usage();
+    }
+    const std::string& directoryPath = paths[0];
+    const std::string& indexPath = paths[1];
+
+    // Same files as the worldserver loads, in a stable order so rebuilds of
+    // an unchanged corpus give the same file
+    std::vector<std::string> files;
+    try {
+        for (const auto& entry : fs::directory_iterator(directoryPath)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".json") {
+                files.push_back(entry.path().string());
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error reading directory " << directoryPath << ": " << e.what() << "\n";
+        return 1;
+    }
+    std::sort(files.begin(), files.end());
+
+    std::vector<RAGEntry> entries;
+    for (const auto& filePath : files) {
+        std::vector<std::string> warnings;
+        std::string error;
+        size_t entriesBefore = entries.size();
+        bool loaded = LoadRAGEntriesFromFile(filePath, entries, warnings, error);
+        for (const auto& warning : warnings) {
+            std::cerr << "warning: " << warning << "\n";
+        }
+        if (!loaded) {
+            std::cerr << "error: " << error << "\n";
+            return 1;
+        }
+        std::cout << "Loaded " << entries.size() - entriesBefore << " entries from " << filePath << "\n";
+    }
+    if (entries.empty()) {
+        std::cerr << "No entries found in " << directoryPath << "\n";
+        return 1;
+    }
+
+    std::vector<char> buffer;
+    std::string error;
+    if (!BuildRAGIndex(entries, boosts, buffer, error)) {
+        std::cerr << "Failed to build index: " << error << "\n";
+        return 1;
+    }
+
+    // Write next to the target and rename over it: a worldserver that has the
+    // old index mapped keeps reading the old file instead of a half-written one
+    std::string tempPath = indexPath + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        if (!out) {
+            std::cerr << "Cannot write " << tempPath << "\n";
+            std::remove(tempPath.c_str());
+            return 1;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tempPath, indexPath, ec);
+    if (ec) {
+        std::cerr << "Cannot replace " << indexPath << ": " << ec.message() << "\n";
+        std::remove(tempPath.c_str());
+        return 1;
+    }
+
+    RAGIndex index;
+    if (!index.Open(indexPath, error)) {
+        std::cerr << "Written index does not open: " << error << "\n";
+        return 1;
+    }
+    std::cout << "Wrote " << indexPath << ": " << index.EntryCount() << " entries, " << index.TermCount()
+              << " terms, " << buffer.size() << " bytes\n";
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Retrieval check against the bundled knowledge base: small talk must not pull
+// in any entry at the default OllamaChat.RAGSimilarityThreshold, and questions
+// naming a topic must rank that topic first.
+//
+// Usage: rag-index-test <json directory>
+
+#include "mod-ollama-chat_rag_index.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Keep in sync with the OllamaChat.RAGSimilarityThreshold default
+static constexpr float DEFAULT_THRESHOLD = 0.3f;
+static constexpr uint32_t MAX_RESULTS = 3;
+
+int main(int argc, char** argv)
+{
+    if (argc != 2) {
+        std::cerr << "Usage: rag-index-test <json directory>\n";
+        return 2;
+    }
+
+    std::vector<std::string> files;
+    for (const auto& entry : fs::directory_iterator(argv[1])) {
+        if (entry.is_regular_file() && entry.path().extension() == ".json") {
+            files.push_back(entry.path().string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    std::vector<RAGEntry> entries;
+    for (const auto& filePath : files) {
+        std::vector<std::string> warnings;
+        std::string error;
+        if (!LoadRAGEntriesFromFile(filePath, entries, warnings, error)) {
+            std::cerr << "error: " << error << "\n";
+            return 1;
+        }
+    }
+
+    std::vector<char> buffer;
+    std::string error;
+    RAGIndex index;
+    if (!BuildRAGIndex(entries, RAGFieldBoosts(), buffer, error) || !index.Load(std::move(buffer), error)) {
+        std::cerr << "Failed to build index: " << error << "\n";
+        return 1;
+    }
+
+    int failures = 0;
+
+    const char* smallTalk[] = {
+        "lol what are you doing",
+        "hey how are you",
+        "haha nice",
+        "what do you think",
+        "nice weather today",
+        "that was fun",
+        "ok see you later",
+        "good job mate",
+        "where are you",
+        "gg",
+    };
+    for (const char* query : smallTalk) {
+        auto hits = index.Search(query, MAX_RESULTS, DEFAULT_THRESHOLD);
+        if (!hits.empty()) {
+            std::cerr << "FAIL \"" << query << "\" matched \"" << index.EntryTitle(hits[0].entryIndex)
+                      << "\" at " << hits[0].score << "\n";
+            ++failures;
+        }
+    }
+
+    struct TopicCase {
+        const char* query;
+        const char* title;
+    };
+    const TopicCase topics[] = {
+        { "how do I get to molten core", "Molten Core" },
+        { "where is molten core", "Molten Core" },
+        { "tell me about blackrock depths", "Blackrock Depths" },
+        { "how do I tank as a warrior", "Warrior" },
+        { "how do I level fishing", "Fishing" },
+        { "what is the alliance capital", "Alliance" },
+        { "how much gold for a mount", "Mount" },
+    };
+    for (const auto& topic : topics) {
+        auto hits = index.Search(topic.query, MAX_RESULTS, DEFAULT_THRESHOLD);
+        if (hits.empty() || index.EntryTitle(hits[0].entryIndex).find(topic.title) == std::string_view::npos) {
+            std::cerr << "FAIL \"" << topic.query << "\" did not rank \"" << topic.title << "\" first";
+            if (!hits.empty()) {
+                std::cerr << " (got \"" << index.EntryTitle(hits[0].entryIndex) << "\" at " << hits[0].score << ")";
+            }
+            std::cerr << "\n";
+            ++failures;
+        }
+    }
+
+    if (failures) {
+        std::cerr << failures << " retrieval checks failed\n";
+        return 1;
+    }
+    std::cout << "All retrieval checks passed\n";
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include "mod-ollama-chat_api.h"
 #include "mod-ollama-chat_config.h"
 #include "mod-ollama-chat_httpclient.h"
+#include "mod-ollama-chat_loadbalancer.h"
 #include "mod-ollama-chat-utilities.h"
 #include "Log.h"
 #include <sstream>
@@ -10,6 +11,8 @@
 #include <mutex>
 #include <queue>
 #include <future>
+#include <functional>
+#include <chrono>
 
 std::string ExtractTextBetweenDoubleQuotes(const std::string& response)
 {
@@ -21,45 +24,64 @@ std::string ExtractTextBetweenDoubleQuotes(const std::string& response)
     return response;
 }
 
-// Function to perform the API call.
-std::string QueryOllamaAPI(const std::string& prompt)
+// Shared HTTP client used by every query worker.
+static OllamaHttpClient& GetHttpClient()
 {
-    // Initialize our custom HTTP client
     static OllamaHttpClient httpClient;
-    
-    if (!httpClient.IsAvailable())
-    {
-        LOG_ERROR("server.loading", "[OllamaChat] ERROR: HTTP client not available. Check if Ollama service is running and accessible.");
-        if(g_DebugEnabled)
-        {
-            LOG_INFO("server.loading", "[OllamaChat] Debug: HTTP client initialization failed.");
-        }
-        return "";
-    }
+    return httpClient;
+}
 
-    std::string url   = g_OllamaUrl;
-    std::string model = g_OllamaModel;
+// Build the request body for a request, using the model profile for its purpose.
+// In chat mode it is a /api/chat body with a messages array, otherwise /api/generate.
+static nlohmann::json BuildGenerateRequest(const OllamaRequest& request, const OllamaPromptConfig& config, bool stream, bool chat)
+{
+    const OllamaModelProfile& profile = config.GetProfile(request.purpose);
 
-    // Sanitize the prompt to ensure it's valid UTF-8 before creating JSON
-    std::string sanitizedPrompt = SanitizeUTF8(prompt);
+    // A per-request system prompt (the stable per-bot prefix) replaces the global one
+    const std::string& systemPrompt = request.system.empty() ? config.systemPrompt : request.system;
 
     nlohmann::json requestData = {
-        {"model",  model},
-        {"prompt", sanitizedPrompt},
-        {"stream", false}
+        {"model",  profile.model},
+        {"stream", stream}
     };
 
+    if (chat)
+    {
+        // System first and the new message last, so consecutive turns share the longest possible prefix
+        nlohmann::json messages = nlohmann::json::array();
+        if (!systemPrompt.empty())
+        {
+            messages.push_back({ {"role", "system"}, {"content", SanitizeUTF8(systemPrompt)} });
+        }
+        for (const OllamaMessage& message : request.history)
+        {
+            messages.push_back({ {"role", message.role}, {"content", SanitizeUTF8(message.content)} });
+        }
+        messages.push_back({ {"role", "user"}, {"content", SanitizeUTF8(request.prompt)} });
+        requestData["messages"] = std::move(messages);
+    }
+    else
+    {
+        // Sanitize the prompt to ensure it's valid UTF-8 before creating JSON
+        requestData["prompt"] = SanitizeUTF8(request.prompt);
+        if (!systemPrompt.empty())
+        {
+            // Sanitize system prompt as well
+            requestData["system"] = SanitizeUTF8(systemPrompt);
+        }
+    }
+
     // Create options object for model parameters
     nlohmann::json options;
     bool hasOptions = false;
 
     // Only include if set (do not send defaults if user did not set them)
-    if (g_OllamaNumPredict > 0) {
-        options["num_predict"] = g_OllamaNumPredict;
+    if (profile.numPredict > 0) {
+        options["num_predict"] = profile.numPredict;
         hasOptions = true;
     }
-    if (g_OllamaTemperature != 0.8f) {
-        options["temperature"] = g_OllamaTemperature;
+    if (profile.temperature != 0.8f) {
+        options["temperature"] = profile.temperature;
         hasOptions = true;
     }
     if (g_OllamaTopP != 0.95f) {
@@ -70,8 +92,8 @@ std::string QueryOllamaAPI(const std::string& prompt)
         options["repeat_penalty"] = g_OllamaRepeatPenalty;
         hasOptions = true;
     }
-    if (g_OllamaNumCtx > 0) {
-        options["num_ctx"] = g_OllamaNumCtx;
+    if (profile.numCtx > 0) {
+        options["num_ctx"] = profile.numCtx;
         hasOptions = true;
     }
     if (g_OllamaNumThreads > 0) {
@@ -83,14 +105,14 @@ std::string QueryOllamaAPI(const std::string& prompt)
     } else if(g_DebugEnabled) {
         //LOG_INFO("server.loading", "[Ollama Chat] g_OllamaNumThreads is: {} (not sending num_thread)", g_OllamaNumThreads);
     }
-    if (!g_OllamaSeed.empty()) {
+    if (!config.seed.empty()) {
         try {
-            int seedValue = std::stoi(g_OllamaSeed);
+            int seedValue = std::stoi(config.seed);
             options["seed"] = seedValue; 
             hasOptions = true;
         } catch (const std::exception& e) {
             if(g_DebugEnabled) {
-                LOG_INFO("server.loading", "[Ollama Chat] Invalid seed value: {}", g_OllamaSeed);
+                LOG_INFO("server.loading", "[Ollama Chat] Invalid seed value: {}", config.seed);
             }
         }
     }
@@ -101,10 +123,10 @@ std::string QueryOllamaAPI(const std::string& prompt)
     }
 
     // Root-level parameters (these stay at root level)
-    if (!g_OllamaStop.empty()) {
+    if (!config.stop.empty()) {
         // If comma-separated, convert to array
         std::vector<std::string> stopSeqs;
-        std::stringstream ss(g_OllamaStop);
+        std::stringstream ss(config.stop);
         std::string item;
         while (std::getline(ss, item, ',')) {
             // trim whitespace
@@ -116,12 +138,6 @@ std::string QueryOllamaAPI(const std::string& prompt)
         if (!stopSeqs.empty())
             requestData["stop"] = stopSeqs;
     }
-    if (!g_OllamaSystemPrompt.empty())
-    {
-        // Sanitize system prompt as well
-        requestData["system"] = SanitizeUTF8(g_OllamaSystemPrompt);
-    }
-
     if (g_ThinkModeEnableForModule)
     {
         if(g_DebugEnabled)
@@ -132,14 +148,80 @@ std::string QueryOllamaAPI(const std::string& prompt)
         requestData["hidethinking"] = true;
     }
 
+    return requestData;
+}
+
+// Check the client and pick a backend for a request. Returns nullptr if no request can be made.
+// Every backend returned here must be handed back with g_LoadBalancer.Release().
+static std::shared_ptr<OllamaBackend> AcquireRequestBackend(OllamaHttpClient& httpClient)
+{
+    if (!httpClient.IsAvailable())
+    {
+        LOG_ERROR("server.loading", "[OllamaChat] ERROR: HTTP client not available. Check if Ollama service is running and accessible.");
+        if(g_DebugEnabled)
+        {
+            LOG_INFO("server.loading", "[OllamaChat] Debug: HTTP client initialization failed.");
+        }
+        return nullptr;
+    }
+
+    // Wait for a free slot no longer than the request itself may take
+    std::shared_ptr<OllamaBackend> backend = g_LoadBalancer.Acquire(std::chrono::seconds(httpClient.GetTimeout()));
+    if (!backend)
+    {
+        LOG_ERROR("server.loading", "[OllamaChat] ERROR: No Ollama backend available. Check OllamaChat.Url / OllamaChat.Backends.");
+    }
+    return backend;
+}
+
+// Generated text in one response line: "response" from /api/generate, "message.content" from /api/chat.
+static std::string GetResponseText(const nlohmann::json& chunk)
+{
+    auto response = chunk.find("response");
+    if (response != chunk.end() && response->is_string())
+        return response->get<std::string>();
+
+    auto message = chunk.find("message");
+    if (message != chunk.end() && message->is_object())
+    {
+        auto content = message->find("content");
+        if (content != message->end() && content->is_string())
+            return content->get<std::string>();
+    }
+    return "";
+}
+
+static uint64_t ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+// Function to perform the API call.
+std::string QueryOllamaAPI(const OllamaRequest& request)
+{
+    OllamaHttpClient& httpClient = GetHttpClient();
+    std::shared_ptr<OllamaBackend> backend = AcquireRequestBackend(httpClient);
+    if (!backend)
+    {
+        return "";
+    }
+    std::shared_ptr<const OllamaPromptConfig> config = GetOllamaPromptConfig();
+    bool chat = config->useChatEndpoint && backend->chatEndpoint;
+    std::shared_ptr<const OllamaEndpoint> endpoint = chat ? backend->chatEndpoint : backend->endpoint;
+
+    nlohmann::json requestData = BuildGenerateRequest(request, *config, false, chat);
+    std::string model = requestData["model"].get<std::string>();
     std::string requestDataStr = requestData.dump();
 
     // Make HTTP POST request using our custom client
-    std::string responseBuffer = httpClient.Post(url, requestDataStr);
+    auto requestStart = std::chrono::steady_clock::now();
+    std::string responseBuffer = httpClient.Post(*endpoint, requestDataStr);
+    g_LoadBalancer.Release(backend, !responseBuffer.empty(), ElapsedMs(requestStart));
 
     if (responseBuffer.empty())
     {
-        LOG_ERROR("server.loading", "[OllamaChat] ERROR: Failed to reach Ollama API at {}. Check URL configuration and network connectivity.", url);
+        LOG_ERROR("server.loading", "[OllamaChat] ERROR: Failed to reach Ollama API at {}. Check URL configuration and network connectivity.", endpoint->url);
         if(g_DebugEnabled)
         {
             LOG_INFO("server.loading", "[OllamaChat] Debug: Empty response buffer from HTTP client. Model: {}", model);
@@ -160,10 +242,7 @@ std::string QueryOllamaAPI(const std::string& prompt)
 
             nlohmann::json jsonResponse = nlohmann::json::parse(line);
 
-            if (jsonResponse.contains("response") && !jsonResponse["response"].get<std::string>().empty())
-            {
-                extractedResponse << jsonResponse["response"].get<std::string>();
-            }
+            extractedResponse << GetResponseText(jsonResponse);
         }
     }
     catch (const std::exception& e)
@@ -220,6 +299,190 @@ std::string QueryOllamaAPI(const std::string& prompt)
     return botReply;
 }
 
+// Trim whitespace and surrounding quotes from a streamed sentence.
+static std::string CleanStreamSentence(const std::string& text)
+{
+    size_t start = text.find_first_not_of(" \t\r\n\"");
+    if (start == std::string::npos)
+        return "";
+    size_t end = text.find_last_not_of(" \t\r\n\"");
+    return text.substr(start, end - start + 1);
+}
+
+// Find the end of the first complete sentence in text: a '.', '!' or '?' run
+// followed by whitespace, or a newline. Returns npos if no sentence is complete yet.
+static size_t FindSentenceEnd(const std::string& text)
+{
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        char c = text[i];
+        if (c == '\n')
+            return i + 1;
+        if (c != '.' && c != '!' && c != '?')
+            continue;
+
+        size_t j = i + 1;
+        while (j < text.size() && (text[j] == '.' || text[j] == '!' || text[j] == '?' || text[j] == '"'))
+            ++j;
+        if (j < text.size() && std::isspace(static_cast<unsigned char>(text[j])))
+            return j;
+        i = j - 1;
+    }
+    return std::string::npos;
+}
+
+// Streaming variant of QueryOllamaAPI. Consumes the NDJSON stream as it
+// arrives and calls onSentence for each complete sentence. Generation is
+// cancelled once OllamaChat.StreamMaxChars characters have been delivered or
+// when onSentence returns false. Returns everything that was delivered.
+std::string QueryOllamaAPIStreaming(const OllamaRequest& request, const std::function<bool(const std::string&)>& onSentence)
+{
+    OllamaHttpClient& httpClient = GetHttpClient();
+    std::shared_ptr<OllamaBackend> backend = AcquireRequestBackend(httpClient);
+    if (!backend)
+    {
+        return "";
+    }
+    std::shared_ptr<const OllamaPromptConfig> config = GetOllamaPromptConfig();
+    bool chat = config->useChatEndpoint && backend->chatEndpoint;
+    std::shared_ptr<const OllamaEndpoint> endpoint = chat ? backend->chatEndpoint : backend->endpoint;
+
+    std::string requestDataStr = BuildGenerateRequest(request, *config, true, chat).dump();
+    auto requestStart = std::chrono::steady_clock::now();
+
+    std::string lineBuffer;     // raw bytes not yet terminated by a newline
+    std::string pendingText;    // generated text not yet delivered
+    std::string delivered;      // everything handed to onSentence
+    bool stopped = false;       // budget reached or caller cancelled
+    bool parseFailed = false;
+
+    // Deliver one sentence, clipping it to the remaining budget. Returns false to stop the stream.
+    auto deliver = [&](const std::string& raw) -> bool {
+        std::string sentence = CleanStreamSentence(raw);
+        if (sentence.empty())
+            return true;
+
+        size_t used = delivered.size() + (delivered.empty() ? 0 : 1);
+        if (g_StreamMaxChars > 0 && used + sentence.size() > g_StreamMaxChars)
+        {
+            // The first sentence is clipped so the bot says something; later ones are dropped
+            if (!delivered.empty())
+                return false;
+            // Cut on a UTF-8 character boundary
+            size_t cut = g_StreamMaxChars;
+            while (cut > 0 && (static_cast<unsigned char>(sentence[cut]) & 0xC0) == 0x80)
+                --cut;
+            sentence.resize(cut);
+        }
+
+        if (!delivered.empty())
+            delivered += ' ';
+        delivered += sentence;
+
+        if (!onSentence(sentence))
+            return false;
+        return g_StreamMaxChars == 0 || delivered.size() < g_StreamMaxChars;
+    };
+
+    // Cut complete sentences off the front of pendingText. Text inside an
+    // unfinished <think> block is held back until the block closes.
+    auto flushSentences = [&](bool final) -> bool {
+        for (;;)
+        {
+            size_t thinkStart = pendingText.find("<think>");
+            if (thinkStart != std::string::npos)
+            {
+                size_t thinkEnd = pendingText.find("</think>", thinkStart);
+                if (thinkEnd == std::string::npos)
+                {
+                    if (!final)
+                        return true;
+                    pendingText.erase(thinkStart);
+                }
+                else
+                {
+                    pendingText.erase(thinkStart, thinkEnd + 8 - thinkStart);
+                }
+                continue;
+            }
+
+            size_t end = FindSentenceEnd(pendingText);
+            if (end == std::string::npos)
+                break;
+            std::string sentence = pendingText.substr(0, end);
+            pendingText.erase(0, end);
+            if (!deliver(sentence))
+                return false;
+        }
+
+        if (final && !pendingText.empty())
+        {
+            std::string rest;
+            rest.swap(pendingText);
+            return deliver(rest);
+        }
+        return true;
+    };
+
+    bool ok = httpClient.PostStream(*endpoint, requestDataStr, [&](const char* data, size_t length) -> bool {
+        lineBuffer.append(data, length);
+
+        size_t newline;
+        while ((newline = lineBuffer.find('\n')) != std::string::npos)
+        {
+            std::string line = lineBuffer.substr(0, newline);
+            lineBuffer.erase(0, newline + 1);
+            if (line.empty() || std::all_of(line.begin(), line.end(), isspace))
+                continue;
+
+            nlohmann::json chunk = nlohmann::json::parse(line, nullptr, false);
+            if (chunk.is_discarded())
+            {
+                LOG_ERROR("server.loading", "[OllamaChat] ERROR: JSON parsing failed for stream line: {}", line);
+                parseFailed = true;
+                return false;
+            }
+            if (chunk.contains("error"))
+            {
+                LOG_ERROR("server.loading", "[OllamaChat] ERROR: Ollama stream error: {}", chunk["error"].dump());
+                parseFailed = true;
+                return false;
+            }
+
+            pendingText += GetResponseText(chunk);
+
+            bool done = chunk.value("done", false);
+            if (!flushSentences(done))
+            {
+                stopped = true;
+                return false;
+            }
+            if (done)
+                return true;
+        }
+        return true;
+    });
+
+    g_LoadBalancer.Release(backend, ok && !parseFailed, ElapsedMs(requestStart));
+
+    if (!ok || parseFailed)
+    {
+        LOG_ERROR("server.loading", "[OllamaChat] ERROR: Streaming request to {} failed.", endpoint->url);
+        return delivered;
+    }
+
+    // Deliver whatever is left if the stream ended without a final "done" chunk
+    if (!stopped && !pendingText.empty())
+        flushSentences(true);
+
+    if(g_DebugEnabled)
+    {
+        LOG_INFO("server.loading", "[Ollama Chat] Streamed bot response ({}): {}", stopped ? "stopped at budget" : "complete", delivered);
+    }
+
+    return delivered;
+}
+
 // Helper function to check if a response is valid (not empty and not an error)
 bool IsValidAPIResponse(const std::string& response)
 {
@@ -234,7 +497,25 @@ bool IsValidAPIResponse(const std::string& response)
 QueryManager g_queryManager;
 
 // Interface function to submit a query.
-std::future<std::string> SubmitQuery(const std::string& prompt)
+std::future<std::string> SubmitQuery(const std::string& prompt, QueryPriority priority, QueryPurpose purpose)
+{
+    return g_queryManager.submitQuery(prompt, priority, purpose);
+}
+
+std::future<std::string> SubmitQuery(OllamaRequest request, QueryPriority priority)
+{
+    return g_queryManager.submitQuery(std::move(request), priority);
+}
+
+std::future<std::string> SubmitStreamingQuery(OllamaRequest request, QueryPriority priority,
+                                              std::function<bool(const std::string&)> onSentence)
+{
+    return g_queryManager.submitQuery(std::move(request), priority, std::move(onSentence));
+}
+
+void SubmitQueryAsync(OllamaRequest request, QueryPriority priority, QueryCompleteFn onComplete,
+                      QuerySentenceFn onSentence, QueryPrepareFn prepare)
 {
-    return g_queryManager.submitQuery(prompt);
+    g_queryManager.submitQueryAsync(std::move(request), priority, std::move(onComplete),
+                                    std::move(onSentence), std::move(prepare));
 }
\ No newline at end of file
@@ -3,15 +3,35 @@
 
 #include <string>
 #include <future>
+#include <functional>
 #include "mod-ollama-chat_querymanager.h"
 
-std::string QueryOllamaAPI(const std::string& prompt);
+std::string QueryOllamaAPI(const OllamaRequest& request);
+
+// Streams the reply and calls onSentence for each complete sentence, stopping at
+// OllamaChat.StreamMaxChars. Returns the text that was delivered.
+std::string QueryOllamaAPIStreaming(const OllamaRequest& request, const std::function<bool(const std::string&)>& onSentence);
 
 // Checks if an API response is valid (not an error message)
 bool IsValidAPIResponse(const std::string& response);
 
-// Submits a query to the API.
-std::future<std::string> SubmitQuery(const std::string& prompt);
+// Submits a query to the API through the QueryManager at the given priority,
+// using the model profile for the given purpose.
+std::future<std::string> SubmitQuery(const std::string& prompt, QueryPriority priority = QueryPriority::Ambient,
+                                     QueryPurpose purpose = QueryPurpose::Conversation);
+
+// Submits a request with its own system prompt.
+std::future<std::string> SubmitQuery(OllamaRequest request, QueryPriority priority);
+
+// Submits a streaming query; onSentence runs on the worker thread for each sentence.
+// The future resolves to everything that was delivered.
+std::future<std::string> SubmitStreamingQuery(OllamaRequest request, QueryPriority priority,
+                                              std::function<bool(const std::string&)> onSentence);
+
+// Submits a request without blocking a thread on the reply: prepare, onSentence
+// and onComplete all run on the worker thread (see QueryManager::submitQueryAsync).
+void SubmitQueryAsync(OllamaRequest request, QueryPriority priority, QueryCompleteFn onComplete,
+                      QuerySentenceFn onSentence = nullptr, QueryPrepareFn prepare = nullptr);
 
 // Declare the global QueryManager variable.
 extern QueryManager g_queryManager;
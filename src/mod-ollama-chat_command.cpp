@@ -2,6 +2,8 @@
 #include "mod-ollama-chat_config.h"
 #include "mod-ollama-chat_sentiment.h"
 #include "mod-ollama-chat_personality.h"
+#include "mod-ollama-chat_api.h"
+#include "mod-ollama-chat_loadbalancer.h"
 #include "Chat.h"
 #include "Config.h"
 #include "ObjectAccessor.h"
@@ -36,7 +38,9 @@ ChatCommandTable OllamaChatConfigCommand::GetCommands() const
     {
         { "reload",      HandleOllamaReloadCommand,  SEC_ADMINISTRATOR, Console::Yes },
         { "sentiment",   ollamaSentimentCommandTable },
-        { "personality", ollamaPersonalityCommandTable }
+        { "personality", ollamaPersonalityCommandTable },
+        { "queue",       HandleOllamaQueueCommand,   SEC_ADMINISTRATOR, Console::Yes },
+        { "backends",    HandleOllamaBackendsCommand, SEC_ADMINISTRATOR, Console::Yes }
     };
 
     static ChatCommandTable commandTable =
@@ -416,3 +420,42 @@ bool OllamaChatConfigCommand::HandleOllamaPersonalityListCommand(ChatHandler* ha
     
     return true;
 }
+
+bool OllamaChatConfigCommand::HandleOllamaQueueCommand(ChatHandler* handler)
+{
+    auto stats = g_queryManager.getStats();
+    size_t totalInFlight = 0;
+    for (const QueryClassStats& s : stats)
+    {
+        totalInFlight += s.inFlight;
+    }
+    handler->SendSysMessage(fmt::format("OllamaChat: Query queue ({} scheduling, {} of {} workers busy):",
+                                        g_QueryWeightedScheduling ? "weighted" : "strict", totalInFlight,
+                                        g_MaxConcurrentQueries ? std::to_string(g_MaxConcurrentQueries) : "auto"));
+    for (size_t i = 0; i < QUERY_PRIORITY_COUNT; ++i)
+    {
+        const QueryClassStats& s = stats[i];
+        uint64_t finished = s.completed + s.failed;
+        handler->SendSysMessage(fmt::format("  {}: queued {} (peak {}), running {}, submitted {}, dropped {}, "
+                                            "completed {}, failed {}, avg latency {}ms, max latency {}ms",
+                                            QueryPriorityName(static_cast<QueryPriority>(i)),
+                                            s.queued, s.peakQueued, s.inFlight, s.submitted, s.dropped,
+                                            s.completed, s.failed, finished ? s.totalLatencyMs / finished : 0,
+                                            s.maxLatencyMs));
+    }
+    return true;
+}
+
+bool OllamaChatConfigCommand::HandleOllamaBackendsCommand(ChatHandler* handler)
+{
+    auto stats = g_LoadBalancer.GetStats();
+    handler->SendSysMessage(fmt::format("OllamaChat: {} backend(s), selection: {}", stats.size(), g_BackendSelection));
+    for (const OllamaBackendStats& backend : stats)
+    {
+        handler->SendSysMessage(fmt::format("  {} [{}] weight {}, in flight {}/{}, requests {}, failures {}, latency ~{:.0f}ms",
+                                            backend.url, backend.down ? "DOWN" : "UP", backend.weight, backend.outstanding,
+                                            backend.maxConcurrent ? std::to_string(backend.maxConcurrent) : "unlimited",
+                                            backend.requests, backend.failures, backend.latencyEwmaMs));
+    }
+    return true;
+}
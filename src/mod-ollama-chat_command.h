@@ -17,6 +17,8 @@ public:
     static bool HandleOllamaPersonalityGetCommand(ChatHandler* handler, std::string botName);
     static bool HandleOllamaPersonalitySetCommand(ChatHandler* handler, std::string botName, std::string personality);
     static bool HandleOllamaPersonalityListCommand(ChatHandler* handler);
+    static bool HandleOllamaQueueCommand(ChatHandler* handler);
+    static bool HandleOllamaBackendsCommand(ChatHandler* handler);
 };
 
 #endif // MOD_OLLAMA_CHAT_COMMAND_H
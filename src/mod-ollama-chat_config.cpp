@@ -4,6 +4,8 @@
 #include "Config.h"
 #include "Log.h"
 #include "mod-ollama-chat_api.h"
+#include "mod-ollama-chat_httpclient.h"
+#include "mod-ollama-chat_loadbalancer.h"
 #include <fmt/core.h>
 #include <sstream>
 #include <fstream>
@@ -41,6 +43,11 @@ uint32_t   g_EventChatterMaxBotsPerPlayer    = 2;
 // Ollama LLM API Configuration
 // --------------------------------------------
 std::string g_OllamaUrl        = "http://localhost:11434/api/generate";
+std::string g_OllamaBackends   = "";
+bool        g_UseChatEndpoint  = false;
+std::string g_BackendSelection = "least-outstanding";
+uint32_t    g_BackendFailureThreshold = 3;
+uint32_t    g_BackendRetryInterval    = 30;
 std::string g_OllamaModel      = "llama3.2:1b";
 uint32_t    g_OllamaNumPredict = 40;
 float       g_OllamaTemperature = 0.8f;
@@ -51,11 +58,29 @@ uint32_t    g_OllamaNumThreads = 0;
 std::string g_OllamaStop = "";
 std::string g_OllamaSystemPrompt = "";
 std::string g_OllamaSeed = "";
+bool        g_EnableStreaming = false;
+uint32_t    g_StreamMaxChars = 255;
+uint32_t    g_MaxRepliesPerTick = 10;
+
+// --------------------------------------------
+// Per-Purpose Model Profiles
+// --------------------------------------------
+OllamaModelProfile g_OllamaModelProfiles[QUERY_PURPOSE_COUNT];
 
 // --------------------------------------------
 // Concurrency/Queueing
 // --------------------------------------------
 uint32_t    g_MaxConcurrentQueries = 0;
+uint32_t    g_MaxQueuedQueries = 64;
+bool        g_QueryWeightedScheduling = false;
+std::string g_QueryPriorityWeights = "32,16,8,4,2,1";
+
+// --------------------------------------------
+// HTTP Connection Pool
+// --------------------------------------------
+uint32_t    g_HttpPoolSize = 4;
+uint32_t    g_HttpPoolIdleTimeout = 30;
+bool        g_HttpPoolHealthCheck = true;
 
 // --------------------------------------------
 // Feature Toggles & Core Settings
@@ -95,6 +120,9 @@ std::vector<std::string> g_RandomChatterQuestionVariations;
 std::string g_EventChatterPromptTemplate;
 std::string g_ChatPromptTemplate;
 std::string g_ChatExtraInfoTemplate;
+bool        g_EnableSplitPrompt = false;
+std::string g_ChatSystemTemplate;
+std::string g_ChatTurnTemplate;
 
 // --------------------------------------------
 // Personality and Prompt Data
@@ -118,6 +146,7 @@ std::string g_ChatHistoryFooterTemplate;
 // --------------------------------------------
 bool        g_EnableChatBotSnapshotTemplate  = false;
 std::string g_ChatBotSnapshotTemplate;
+uint32_t    g_SnapshotMaxVisibleObjects = 15;
 
 // --------------------------------------------
 // Conversation History Store and Mutex
@@ -146,9 +175,14 @@ time_t g_LastSentimentSaveTime = 0;
 // --------------------------------------------
 bool        g_EnableRAG = false;
 std::string g_RAGDataPath = "rag/";
+std::string g_RAGIndexFile = "";
 uint32_t    g_RAGMaxRetrievedItems = 3;
 float       g_RAGSimilarityThreshold = 0.3f;
 std::string g_RAGPromptTemplate;
+float       g_RAGTitleBoost = 2.0f;
+float       g_RAGKeywordsBoost = 1.5f;
+float       g_RAGTagsBoost = 1.0f;
+float       g_RAGContentBoost = 1.0f;
 
 class OllamaRAGSystem;
 OllamaRAGSystem* g_RAGSystem = nullptr;
@@ -368,6 +402,55 @@ std::string GetMultiLineConfigValue(const std::string& configFilePath, const std
     return value;
 }
 
+// --------------------------------------------
+// Prompt Settings Snapshot
+// --------------------------------------------
+static std::shared_ptr<const OllamaPromptConfig> s_PromptConfig = std::make_shared<OllamaPromptConfig>();
+
+const OllamaModelProfile& OllamaPromptConfig::GetProfile(QueryPurpose purpose) const
+{
+    size_t index = static_cast<size_t>(purpose);
+    return profiles[index < QUERY_PURPOSE_COUNT ? index : 0];
+}
+
+std::shared_ptr<const OllamaPromptConfig> GetOllamaPromptConfig()
+{
+    return std::atomic_load(&s_PromptConfig);
+}
+
+// Copy the freshly loaded settings into a new snapshot and swap it in; threads
+// still holding the previous one keep using it until their reply is done.
+static void PublishOllamaPromptConfig()
+{
+    auto config = std::make_shared<OllamaPromptConfig>();
+    config->enableSplitPrompt         = g_EnableSplitPrompt;
+    config->chatPromptTemplate        = g_ChatPromptTemplate;
+    config->chatTurnTemplate          = g_ChatTurnTemplate;
+    config->chatSystemTemplate        = g_ChatSystemTemplate;
+    config->chatExtraInfoTemplate     = g_ChatExtraInfoTemplate;
+    config->chatBotSnapshotTemplate   = g_ChatBotSnapshotTemplate;
+    config->enableChatHistory         = g_EnableChatHistory;
+    config->chatHistoryHeaderTemplate = g_ChatHistoryHeaderTemplate;
+    config->chatHistoryLineTemplate   = g_ChatHistoryLineTemplate;
+    config->chatHistoryFooterTemplate = g_ChatHistoryFooterTemplate;
+    config->enableRAG                 = g_EnableRAG;
+    config->ragMaxRetrievedItems      = g_RAGMaxRetrievedItems;
+    config->ragSimilarityThreshold    = g_RAGSimilarityThreshold;
+    config->ragPromptTemplate         = g_RAGPromptTemplate;
+    config->sentimentAnalysisPrompt   = g_SentimentAnalysisPrompt;
+    config->useChatEndpoint           = g_UseChatEndpoint;
+    config->systemPrompt              = g_OllamaSystemPrompt;
+    config->stop                      = g_OllamaStop;
+    config->seed                      = g_OllamaSeed;
+    for (size_t i = 0; i < QUERY_PURPOSE_COUNT; ++i)
+    {
+        config->profiles[i] = g_OllamaModelProfiles[i];
+    }
+    config->debugShowFullPrompt       = g_DebugShowFullPrompt;
+
+    std::atomic_store(&s_PromptConfig, std::shared_ptr<const OllamaPromptConfig>(std::move(config)));
+}
+
 void LoadOllamaChatConfig()
 {
     g_SayDistance                     = sConfigMgr->GetOption<float>("OllamaChat.SayDistance", 30.0f);
@@ -385,6 +468,11 @@ void LoadOllamaChatConfig()
     
     g_MaxBotsToPick                   = sConfigMgr->GetOption<uint32_t>("OllamaChat.MaxBotsToPick", 2);
     g_OllamaUrl                       = sConfigMgr->GetOption<std::string>("OllamaChat.Url", "http://localhost:11434/api/generate");
+    g_OllamaBackends                  = sConfigMgr->GetOption<std::string>("OllamaChat.Backends", "");
+    g_UseChatEndpoint                 = sConfigMgr->GetOption<bool>("OllamaChat.UseChatEndpoint", false);
+    g_BackendSelection                = sConfigMgr->GetOption<std::string>("OllamaChat.BackendSelection", "least-outstanding");
+    g_BackendFailureThreshold         = sConfigMgr->GetOption<uint32_t>("OllamaChat.BackendFailureThreshold", 3);
+    g_BackendRetryInterval            = sConfigMgr->GetOption<uint32_t>("OllamaChat.BackendRetryInterval", 30);
     g_OllamaModel                     = sConfigMgr->GetOption<std::string>("OllamaChat.Model", "llama3.2:1b");
     g_OllamaNumPredict                = sConfigMgr->GetOption<uint32_t>("OllamaChat.NumPredict", 40);
     g_OllamaTemperature               = sConfigMgr->GetOption<float>("OllamaChat.Temperature", 0.8f);
@@ -395,8 +483,38 @@ void LoadOllamaChatConfig()
     g_OllamaStop                      = sConfigMgr->GetOption<std::string>("OllamaChat.Stop", "");
     g_OllamaSystemPrompt              = sConfigMgr->GetOption<std::string>("OllamaChat.SystemPrompt", "");
     g_OllamaSeed                      = sConfigMgr->GetOption<std::string>("OllamaChat.Seed", "");
+    g_EnableStreaming                 = sConfigMgr->GetOption<bool>("OllamaChat.EnableStreaming", false);
+    g_StreamMaxChars                  = sConfigMgr->GetOption<uint32_t>("OllamaChat.StreamMaxChars", 255);
+    g_MaxRepliesPerTick               = sConfigMgr->GetOption<uint32_t>("OllamaChat.MaxRepliesPerTick", 10);
+
+    // Per-purpose profiles: an empty model or a negative number inherits the global setting.
+    for (size_t i = 0; i < QUERY_PURPOSE_COUNT; ++i)
+    {
+        std::string prefix = fmt::format("OllamaChat.Profile.{}.", QueryPurposeName(static_cast<QueryPurpose>(i)));
+        OllamaModelProfile& profile = g_OllamaModelProfiles[i];
+
+        profile.model = sConfigMgr->GetOption<std::string>(prefix + "Model", "");
+        if (profile.model.empty())
+            profile.model = g_OllamaModel;
+
+        int32_t numPredict = sConfigMgr->GetOption<int32_t>(prefix + "NumPredict", -1);
+        profile.numPredict = numPredict < 0 ? g_OllamaNumPredict : static_cast<uint32_t>(numPredict);
+
+        int32_t numCtx = sConfigMgr->GetOption<int32_t>(prefix + "NumCtx", -1);
+        profile.numCtx = numCtx < 0 ? g_OllamaNumCtx : static_cast<uint32_t>(numCtx);
+
+        float temperature = sConfigMgr->GetOption<float>(prefix + "Temperature", -1.0f);
+        profile.temperature = temperature < 0.0f ? g_OllamaTemperature : temperature;
+    }
 
     g_MaxConcurrentQueries            = sConfigMgr->GetOption<uint32_t>("OllamaChat.MaxConcurrentQueries", 0);
+    g_MaxQueuedQueries                = sConfigMgr->GetOption<uint32_t>("OllamaChat.MaxQueuedQueries", 64);
+    g_QueryWeightedScheduling         = sConfigMgr->GetOption<bool>("OllamaChat.QueryWeightedScheduling", false);
+    g_QueryPriorityWeights            = sConfigMgr->GetOption<std::string>("OllamaChat.QueryPriorityWeights", "32,16,8,4,2,1");
+
+    g_HttpPoolSize                    = sConfigMgr->GetOption<uint32_t>("OllamaChat.HttpPoolSize", 4);
+    g_HttpPoolIdleTimeout             = sConfigMgr->GetOption<uint32_t>("OllamaChat.HttpPoolIdleTimeout", 30);
+    g_HttpPoolHealthCheck             = sConfigMgr->GetOption<bool>("OllamaChat.HttpPoolHealthCheck", true);
 
     g_Enable                          = sConfigMgr->GetOption<bool>("OllamaChat.Enable", true);
     g_DisableRepliesInCombat          = sConfigMgr->GetOption<bool>("OllamaChat.DisableRepliesInCombat", true);
@@ -463,6 +581,12 @@ void LoadOllamaChatConfig()
     
     g_ChatExtraInfoTemplate           = sConfigMgr->GetOption<std::string>("OllamaChat.ChatExtraInfoTemplate", "");
 
+    g_EnableSplitPrompt               = sConfigMgr->GetOption<bool>("OllamaChat.EnableSplitPrompt", false);
+
+    g_ChatSystemTemplate              = sConfigMgr->GetOption<std::string>("OllamaChat.ChatSystemTemplate", "You're a Wrath-era WoW player familiar with Vanilla and TBC. Name: {bot_name}, Level: {bot_level} {bot_race} {bot_gender} {bot_class}, Faction: {bot_faction}. MAKE SURE YOU RESPOND USING YOUR PERSONALITY, WHICH IS: {bot_personality_name}: {bot_personality}. Reply naturally in under 15 words. Use authentic WoW tone. Be blunt if provoked. Be precise if giving directions. Never contradict your class, race, or location. Never act like a narrator—just respond like a player.");
+
+    g_ChatTurnTemplate                = sConfigMgr->GetOption<std::string>("OllamaChat.ChatTurnTemplate", "{chat_history} {sentiment_info} A level {player_level} {player_class} named {player_name} said: '{player_message}'. {extra_info}");
+
     g_DefaultPersonalityPrompt        = sConfigMgr->GetOption<std::string>("OllamaChat.DefaultPersonalityPrompt", "");
 
     g_MaxConversationHistory          = sConfigMgr->GetOption<uint32_t>("OllamaChat.MaxConversationHistory", 5);
@@ -474,6 +598,7 @@ void LoadOllamaChatConfig()
 
     g_EnableChatBotSnapshotTemplate   = sConfigMgr->GetOption<bool>("OllamaChat.EnableChatBotSnapshotTemplate", false);
     g_ChatBotSnapshotTemplate         = sConfigMgr->GetOption<std::string>("OllamaChat.ChatBotSnapshotTemplate", "");
+    g_SnapshotMaxVisibleObjects       = sConfigMgr->GetOption<uint32_t>("OllamaChat.SnapshotMaxVisibleObjects", 15);
 
     g_EnableChatHistory               = sConfigMgr->GetOption<bool>("OllamaChat.EnableChatHistory", true);
 
@@ -488,9 +613,14 @@ void LoadOllamaChatConfig()
     // RAG (Retrieval-Augmented Generation) System
     g_EnableRAG                       = sConfigMgr->GetOption<bool>("OllamaChat.EnableRAG", false);
     g_RAGDataPath                     = sConfigMgr->GetOption<std::string>("OllamaChat.RAGDataPath", "rag/");
+    g_RAGIndexFile                    = sConfigMgr->GetOption<std::string>("OllamaChat.RAGIndexFile", "");
     g_RAGMaxRetrievedItems            = sConfigMgr->GetOption<uint32_t>("OllamaChat.RAGMaxRetrievedItems", 3);
     g_RAGSimilarityThreshold          = sConfigMgr->GetOption<float>("OllamaChat.RAGSimilarityThreshold", 0.3f);
     g_RAGPromptTemplate               = sConfigMgr->GetOption<std::string>("OllamaChat.RAGPromptTemplate", "RELEVANT INFORMATION:\n{rag_info}\nUse this information to provide accurate and detailed responses when applicable.");
+    g_RAGTitleBoost                   = sConfigMgr->GetOption<float>("OllamaChat.RAGTitleBoost", 2.0f);
+    g_RAGKeywordsBoost                = sConfigMgr->GetOption<float>("OllamaChat.RAGKeywordsBoost", 1.5f);
+    g_RAGTagsBoost                    = sConfigMgr->GetOption<float>("OllamaChat.RAGTagsBoost", 1.0f);
+    g_RAGContentBoost                 = sConfigMgr->GetOption<float>("OllamaChat.RAGContentBoost", 1.0f);
 
     g_ThinkModeEnableForModule        = sConfigMgr->GetOption<bool>("OllamaChat.ThinkModeEnableForModule", false);
 
@@ -527,7 +657,44 @@ void LoadOllamaChatConfig()
 
     LoadPersonalityTemplatesFromDB();
 
+    // Parse the backend URLs once here; requests share them until the next reload.
+    // Without OllamaChat.Backends the single OllamaChat.Url is the only backend.
+    {
+        std::vector<std::shared_ptr<OllamaBackend>> backends = ParseOllamaBackends(g_OllamaBackends.empty() ? g_OllamaUrl : g_OllamaBackends);
+        if (!backends.empty())
+        {
+            BackendSelection selection = g_BackendSelection == "latency" ? BackendSelection::LatencyEwma
+                                                                          : BackendSelection::LeastOutstanding;
+            LOG_INFO("server.loading", "[Ollama Chat] Using {} Ollama backend(s), selection: {}", backends.size(),
+                     selection == BackendSelection::LatencyEwma ? "latency" : "least-outstanding");
+            g_LoadBalancer.Configure(std::move(backends), selection, g_BackendFailureThreshold, g_BackendRetryInterval);
+        }
+        else
+        {
+            LOG_ERROR("server.loading", "[Ollama Chat] No valid backend URL in OllamaChat.Url / OllamaChat.Backends, expected "
+                      "http(s)://host[:port][/path]. Keeping the previous backends.");
+        }
+    }
+
     g_queryManager.setMaxConcurrentQueries(g_MaxConcurrentQueries);
+    g_queryManager.setBackendCapacity(g_LoadBalancer.GetTotalCapacity());
+    g_queryManager.setMaxQueueSize(g_MaxQueuedQueries);
+    g_queryManager.setWeightedScheduling(g_QueryWeightedScheduling);
+    {
+        std::vector<uint32_t> weights;
+        for (const auto& token : SplitString(g_QueryPriorityWeights, ','))
+        {
+            try
+            {
+                weights.push_back(static_cast<uint32_t>(std::stoul(token)));
+            }
+            catch (...)
+            {
+                weights.push_back(1);
+            }
+        }
+        g_queryManager.setPriorityWeights(weights);
+    }
 
     // Loads the environment random chatter message templates for each type.
     // Each config option is a pipe-separated list of string templates,
@@ -631,6 +798,8 @@ void LoadOllamaChatConfig()
     g_DisableForGuild = sConfigMgr->GetOption<bool>("OllamaChat.DisableForGuild", false);
     g_DisableForParty = sConfigMgr->GetOption<bool>("OllamaChat.DisableForParty", false);
 
+    PublishOllamaPromptConfig();
+
     LOG_INFO("server.loading",
              "[Ollama Chat] Config loaded: Enabled = {}, SayDistance = {}, YellDistance = {}, "
              "Reply Chances - Say: P{}%/B{}%, Channel: P{}%/B{}%, Party: P{}%/B{}%, Guild: P{}%/B{}%, MaxBotsToPick = {}, "
@@ -737,6 +906,11 @@ void OllamaChatConfigWorldScript::OnStartup()
 
 void OllamaChatConfigWorldScript::OnShutdown()
 {
+    // Stop the query worker pool before anything it uses is torn down. Workers
+    // waiting for a backend slot are released first so they can be joined.
+    g_LoadBalancer.Shutdown();
+    g_queryManager.shutdown();
+
     // Clean up RAG system
     if (g_RAGSystem) {
         delete g_RAGSystem;
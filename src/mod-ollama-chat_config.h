@@ -8,7 +8,9 @@
 #include <unordered_map>
 #include <mutex>
 #include <ctime>
+#include <memory>
 #include "ScriptMgr.h"  // Ensure WorldScript is defined
+#include "mod-ollama-chat_querymanager.h"  // For QueryPurpose
 
 // --------------------------------------------
 // Distance/Range Configuration
@@ -42,6 +44,11 @@ extern uint32_t   g_EventChatterMaxBotsPerPlayer;
 // Ollama LLM API Configuration
 // --------------------------------------------
 extern std::string g_OllamaUrl;
+extern std::string g_OllamaBackends;
+extern bool        g_UseChatEndpoint;
+extern std::string g_BackendSelection;
+extern uint32_t    g_BackendFailureThreshold;
+extern uint32_t    g_BackendRetryInterval;
 extern std::string g_OllamaModel;
 extern uint32_t    g_OllamaNumPredict;
 extern float       g_OllamaTemperature;
@@ -52,11 +59,39 @@ extern uint32_t    g_OllamaNumThreads;
 extern std::string g_OllamaStop;
 extern std::string g_OllamaSystemPrompt;
 extern std::string g_OllamaSeed;
+extern bool        g_EnableStreaming;
+extern uint32_t    g_StreamMaxChars;
+extern uint32_t    g_MaxRepliesPerTick;
+
+// --------------------------------------------
+// Per-Purpose Model Profiles
+// --------------------------------------------
+// Model and generation options for one kind of request. Unset profile
+// options fall back to the global OllamaChat.Model/NumPredict/NumCtx/Temperature.
+struct OllamaModelProfile
+{
+    std::string model;
+    uint32_t    numPredict;
+    uint32_t    numCtx;
+    float       temperature;
+};
+
+extern OllamaModelProfile g_OllamaModelProfiles[QUERY_PURPOSE_COUNT];
 
 // --------------------------------------------
 // Concurrency/Queueing
 // --------------------------------------------
 extern uint32_t    g_MaxConcurrentQueries;
+extern uint32_t    g_MaxQueuedQueries;
+extern bool        g_QueryWeightedScheduling;
+extern std::string g_QueryPriorityWeights;
+
+// --------------------------------------------
+// HTTP Connection Pool
+// --------------------------------------------
+extern uint32_t    g_HttpPoolSize;
+extern uint32_t    g_HttpPoolIdleTimeout;
+extern bool        g_HttpPoolHealthCheck;
 
 // --------------------------------------------
 // Feature Toggles & Core Settings
@@ -91,6 +126,9 @@ extern std::vector<std::string> g_RandomChatterQuestionVariations;
 extern std::string g_EventChatterPromptTemplate;
 extern std::string g_ChatPromptTemplate;
 extern std::string g_ChatExtraInfoTemplate;
+extern bool        g_EnableSplitPrompt;
+extern std::string g_ChatSystemTemplate;
+extern std::string g_ChatTurnTemplate;
 
 // --------------------------------------------
 // Personality and Prompt Data
@@ -114,6 +152,7 @@ extern std::string g_ChatHistoryFooterTemplate;
 // --------------------------------------------
 extern bool        g_EnableChatBotSnapshotTemplate;
 extern std::string g_ChatBotSnapshotTemplate;
+extern uint32_t    g_SnapshotMaxVisibleObjects;
 
 // --------------------------------------------
 // Conversation History Store and Mutex
@@ -234,9 +273,14 @@ extern time_t g_LastSentimentSaveTime;
 // --------------------------------------------
 extern bool        g_EnableRAG;                          // Enable/disable RAG feature
 extern std::string g_RAGDataPath;                        // Path to RAG data files
+extern std::string g_RAGIndexFile;                       // Prebuilt binary RAG index, mapped instead of loading JSON
 extern uint32_t    g_RAGMaxRetrievedItems;               // Max items to retrieve
 extern float       g_RAGSimilarityThreshold;             // Similarity threshold for retrieval
 extern std::string g_RAGPromptTemplate;                  // Template for RAG info in prompts
+extern float       g_RAGTitleBoost;                      // BM25 field weight of entry titles
+extern float       g_RAGKeywordsBoost;                   // BM25 field weight of entry keywords
+extern float       g_RAGTagsBoost;                       // BM25 field weight of entry tags
+extern float       g_RAGContentBoost;                    // BM25 field weight of entry content
 
 class OllamaRAGSystem;
 extern OllamaRAGSystem* g_RAGSystem;                     // Global RAG system instance
@@ -278,6 +322,47 @@ extern bool g_EnableTypingSimulation;
 extern uint32_t g_TypingSimulationBaseDelay;      // Base delay in milliseconds
 extern uint32_t g_TypingSimulationDelayPerChar;   // Delay per character in milliseconds
 
+// --------------------------------------------
+// Prompt Settings Snapshot
+// --------------------------------------------
+// Copy of the settings read off the world thread to build a prompt and its
+// request body. LoadOllamaChatConfig publishes a new one on every load, so a
+// reload never changes these strings under a worker; a reply keeps the copy
+// it was captured with.
+struct OllamaPromptConfig
+{
+    bool        enableSplitPrompt = false;
+    std::string chatPromptTemplate;
+    std::string chatTurnTemplate;
+    std::string chatSystemTemplate;
+    std::string chatExtraInfoTemplate;
+    std::string chatBotSnapshotTemplate;
+
+    bool        enableChatHistory = false;
+    std::string chatHistoryHeaderTemplate;
+    std::string chatHistoryLineTemplate;
+    std::string chatHistoryFooterTemplate;
+
+    bool        enableRAG = false;
+    uint32_t    ragMaxRetrievedItems = 0;
+    float       ragSimilarityThreshold = 0.0f;
+    std::string ragPromptTemplate;
+
+    std::string sentimentAnalysisPrompt;
+
+    bool        useChatEndpoint = false;
+    std::string systemPrompt;
+    std::string stop;
+    std::string seed;
+    OllamaModelProfile profiles[QUERY_PURPOSE_COUNT];
+    bool        debugShowFullPrompt = false;
+
+    const OllamaModelProfile& GetProfile(QueryPurpose purpose) const;
+};
+
+// The settings of the last config load; never null once the module started
+std::shared_ptr<const OllamaPromptConfig> GetOllamaPromptConfig();
+
 // --------------------------------------------
 // Loader Functions
 // --------------------------------------------
@@ -5,6 +5,8 @@
 #include "mod-ollama-chat-utilities.h"
 #include "mod-ollama-chat_personality.h"
 #include "mod-ollama-chat_sentiment.h"
+#include "mod-ollama-chat_presence.h"
+#include "mod-ollama-chat_outbox.h"
 #include "Player.h"
 #include "ObjectAccessor.h"
 #include "Guild.h"
@@ -36,7 +38,7 @@ void OllamaBotEventChatter::DispatchGameEvent(Player* source, std::string type,
        return;
     }
 
-    bool isSourceBot = PlayerbotsMgr::instance().GetPlayerbotAI(source) != nullptr;
+    bool isSourceBot = HasPlayerbotAI(source);
     bool hasNearbyRealPlayer = false;
     bool isGuildEvent = false;
 
@@ -61,7 +63,7 @@ void OllamaBotEventChatter::DispatchGameEvent(Player* source, std::string type,
                 Player* player = pair.second;
                 if (!player || !player->IsInWorld())
                     continue;
-                if (PlayerbotsMgr::instance().GetPlayerbotAI(player))
+                if (HasPlayerbotAI(player))
                     continue;
                 if (player->GetGuild() && player->GetGuild()->GetId() == guild->GetId()) {
                     isGuildEvent = true;
@@ -78,7 +80,7 @@ void OllamaBotEventChatter::DispatchGameEvent(Player* source, std::string type,
         if (player == source)
             continue;
 
-        if (!PlayerbotsMgr::instance().GetPlayerbotAI(player) && player->IsWithinDist(source, g_EventChatterRealPlayerDistance, false))
+        if (!HasPlayerbotAI(player) && player->IsWithinDist(source, g_EventChatterRealPlayerDistance, false))
         {
             hasNearbyRealPlayer = true;
             break;
@@ -112,8 +114,7 @@ void OllamaBotEventChatter::DispatchGameEvent(Player* source, std::string type,
             if (!player || !player->IsInWorld())
                 continue;
                 
-            PlayerbotAI* ai = PlayerbotsMgr::instance().GetPlayerbotAI(player);
-            if (!ai)
+            if (!HasPlayerbotAI(player))
                 continue;
                 
             if (!player->GetGuild() || player->GetGuild()->GetId() != guild->GetId())
@@ -127,7 +128,7 @@ void OllamaBotEventChatter::DispatchGameEvent(Player* source, std::string type,
                 if (!guildPlayer || !guildPlayer->IsInWorld())
                     continue;
                     
-                if (PlayerbotsMgr::instance().GetPlayerbotAI(guildPlayer))
+                if (HasPlayerbotAI(guildPlayer))
                     continue;
                     
                 if (guildPlayer->GetGuild() && guildPlayer->GetGuild()->GetId() == guild->GetId())
@@ -284,135 +285,134 @@ void OllamaBotEventChatter::DispatchGameEvent(Player* source, std::string type,
 }
 
 
+// Outbox handler: says an event reply in guild, party, Say or General.
+static void DeliverEventReply(Player* bot, const OllamaReply& reply)
+{
+    PlayerbotAI* botAI = PlayerbotsMgr::instance().GetPlayerbotAI(bot);
+    if (!botAI) return;
+
+    // Route response to random appropriate channel
+    if (reply.guild && bot->GetGuild())
+    {
+        // Check if guild chat is disabled
+        if (g_DisableForGuild)
+        {
+            if (g_DebugEnabled)
+                LOG_INFO("server.loading", "[Ollama Chat] Guild event chatter skipped (guild channels disabled)");
+            return;
+        }
+        
+        botAI->SayToGuild(reply.text);
+    }
+    else if (bot->GetGroup())
+    {
+        // Check if party chat is disabled
+        if (g_DisableForParty)
+        {
+            if (g_DebugEnabled)
+                LOG_INFO("server.loading", "[Ollama Chat] Party event chatter skipped (party channels disabled)");
+            return;
+        }
+        
+        botAI->SayToParty(reply.text);
+    }
+    else
+    {
+        // For solo bots, randomly pick between Say and General channel
+        std::vector<std::string> channels;
+        
+        // Only add General if custom channels are not disabled
+        if (!g_DisableForCustomChannels)
+        {
+            channels.push_back("General");
+        }
+        
+        // Only add Say if not disabled
+        if (!g_DisableForSayYell)
+        {
+            channels.push_back("Say");
+        }
+        
+        // If no channels are available, skip event chatter
+        if (channels.empty())
+        {
+            if (g_DebugEnabled)
+                LOG_INFO("server.loading", "[Ollama Chat] Bot {} skipping event chatter (all available channels disabled)", bot->GetName());
+            return;
+        }
+        
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<size_t> dist(0, channels.size() - 1);
+        std::string selectedChannel = channels[dist(gen)];
+        
+        if (selectedChannel == "Say")
+        {
+            if (g_DebugEnabled)
+                LOG_INFO("server.loading", "[Ollama Chat] Bot Event Chatter Say: {}", reply.text);
+            botAI->Say(reply.text);
+        }
+        else if (selectedChannel == "General")
+        {
+            if (g_DebugEnabled)
+                LOG_INFO("server.loading", "[Ollama Chat] Bot Event Chatter General: {}", reply.text);
+            
+            // Use playerbots' SayToChannel method if available, otherwise use direct channel access
+            if (!botAI->SayToChannel(reply.text, ChatChannelId::GENERAL))
+            {
+                // Fallback to Say if channel message failed
+                if (g_DebugEnabled)
+                    LOG_INFO("server.loading", "[Ollama Chat] Failed to send to General channel, falling back to Say");
+                botAI->Say(reply.text);
+            }
+        }
+    }
+}
+
 void OllamaBotEventChatter::QueueEvent(Player* bot, std::string type, std::string detail, std::string actorName, bool isGuildEvent)
 {
     if (!g_Enable || !g_EnableEventChatter || !bot)
         return;
 
+    // Build the prompt here on the world thread; the reply is handled on the query worker.
+    OllamaRequest request;
+    request.prompt = BuildPrompt(bot, g_EventChatterPromptTemplate, type, detail, actorName);
+    if (request.prompt.empty())
+        return;
+    request.purpose = isGuildEvent ? QueryPurpose::Guild : QueryPurpose::Event;
+
     uint64_t botGuid = bot->GetGUID().GetRawValue();
 
-    std::thread([this, botGuid, type, detail, actorName, isGuildEvent]()
-    {
-        try
+    // Use the QueryManager so event bursts share the global concurrency budget.
+    SubmitQueryAsync(std::move(request), QueryPriority::Event,
+        [botGuid, isGuildEvent](std::string response)
         {
-            Player* botPtr = ObjectAccessor::FindPlayer(ObjectGuid(botGuid));
-            if (!botPtr) return;
-
-            std::string prompt = BuildPrompt(botPtr, g_EventChatterPromptTemplate, type, detail, actorName);
-            if (prompt.empty()) return;
-
-            std::string response = QueryOllamaAPI(prompt);
             if (response.empty())
             {
                 if (g_DebugEnabled)
-                    LOG_INFO("server.loading", "[OllamaChat] Bot {} skipped event response due to API error", botPtr->GetName());
+                    LOG_INFO("server.loading", "[OllamaChat] Bot {} skipped event response due to API error", botGuid);
                 return;
             }
 
-            // reacquire pointers before use
-            botPtr = ObjectAccessor::FindPlayer(ObjectGuid(botGuid));
-            if (!botPtr) return;
-            PlayerbotAI* botAI = PlayerbotsMgr::instance().GetPlayerbotAI(botPtr);
-            if (!botAI) return;
+            // The world thread picks the channel and sends it
+            OllamaReply reply;
 
-            // Simulate typing delay if enabled
+            // Simulate typing delay if enabled; the outbox holds the reply until then
             if (g_EnableTypingSimulation)
             {
-                uint32_t delay = g_TypingSimulationBaseDelay + (response.length() * g_TypingSimulationDelayPerChar);
+                auto delay = GetTypingDelay(response.length());
                 if (g_DebugEnabled)
                     LOG_INFO("server.loading", "[OllamaChat] Bot {} simulating typing delay: {}ms for {} characters", 
-                             botPtr->GetName(), delay, response.length());
-                std::this_thread::sleep_for(std::chrono::milliseconds(delay));
-                
-                // Reacquire pointers after delay
-                botPtr = ObjectAccessor::FindPlayer(ObjectGuid(botGuid));
-                if (!botPtr) return;
-                botAI = PlayerbotsMgr::instance().GetPlayerbotAI(botPtr);
-                if (!botAI) return;
+                             botGuid, delay.count(), response.length());
+                reply.notBefore = std::chrono::steady_clock::now() + delay;
             }
 
-            // Route response to random appropriate channel
-            if (isGuildEvent && botPtr->GetGuild())
-            {
-                // Check if guild chat is disabled
-                if (g_DisableForGuild)
-                {
-                    if (g_DebugEnabled)
-                        LOG_INFO("server.loading", "[Ollama Chat] Guild event chatter skipped (guild channels disabled)");
-                    return;
-                }
-                
-                botAI->SayToGuild(response);
-            }
-            else if (botPtr->GetGroup())
-            {
-                // Check if party chat is disabled
-                if (g_DisableForParty)
-                {
-                    if (g_DebugEnabled)
-                        LOG_INFO("server.loading", "[Ollama Chat] Party event chatter skipped (party channels disabled)");
-                    return;
-                }
-                
-                botAI->SayToParty(response);
-            }
-            else
-            {
-                // For solo bots, randomly pick between Say and General channel
-                std::vector<std::string> channels;
-                
-                // Only add General if custom channels are not disabled
-                if (!g_DisableForCustomChannels)
-                {
-                    channels.push_back("General");
-                }
-                
-                // Only add Say if not disabled
-                if (!g_DisableForSayYell)
-                {
-                    channels.push_back("Say");
-                }
-                
-                // If no channels are available, skip event chatter
-                if (channels.empty())
-                {
-                    if (g_DebugEnabled)
-                        LOG_INFO("server.loading", "[Ollama Chat] Bot {} skipping event chatter (all available channels disabled)", botPtr->GetName());
-                    return;
-                }
-                
-                std::random_device rd;
-                std::mt19937 gen(rd());
-                std::uniform_int_distribution<size_t> dist(0, channels.size() - 1);
-                std::string selectedChannel = channels[dist(gen)];
-                
-                if (selectedChannel == "Say")
-                {
-                    if (g_DebugEnabled)
-                        LOG_INFO("server.loading", "[Ollama Chat] Bot Event Chatter Say: {}", response);
-                    botAI->Say(response);
-                }
-                else if (selectedChannel == "General")
-                {
-                    if (g_DebugEnabled)
-                        LOG_INFO("server.loading", "[Ollama Chat] Bot Event Chatter General: {}", response);
-                    
-                    // Use playerbots' SayToChannel method if available, otherwise use direct channel access
-                    if (!botAI->SayToChannel(response, ChatChannelId::GENERAL))
-                    {
-                        // Fallback to Say if channel message failed
-                        if (g_DebugEnabled)
-                            LOG_INFO("server.loading", "[Ollama Chat] Failed to send to General channel, falling back to Say");
-                        botAI->Say(response);
-                    }
-                }
-            }
-        }
-        catch (const std::exception& e)
-        {
-            LOG_ERROR("server.loading", "[OllamaChat] Exception in QueueEvent thread: {}", e.what());
-        }
-    }).detach();
+            reply.deliver = DeliverEventReply;
+            reply.botGuid = botGuid;
+            reply.text = std::move(response);
+            reply.guild = isGuildEvent;
+            g_ReplyOutbox.Push(std::move(reply));
+        });
 }
 
 
@@ -647,7 +647,7 @@ void ChatOnAchievement::OnPlayerCompleteAchievement(Player* player, AchievementE
     // Guild-specific achievement event for real players only
     if (player->GetGuild() && g_EnableGuildEventChatter && !g_GuildEventTypeGuildAchievement.empty())
     {
-        if (!PlayerbotsMgr::instance().GetPlayerbotAI(player)) // Only real players
+        if (!HasPlayerbotAI(player)) // Only real players
             eventChatter.DispatchGameEvent(player, g_GuildEventTypeGuildAchievement, achievement->name[0]);
     }
 }
@@ -707,7 +707,7 @@ void ChatOnGuildMemberChange::OnGuildMemberLogin(Player* player, Guild* guild)
 {
     if (!player || !guild || !g_EnableGuildEventChatter)
         return;
-    if (PlayerbotsMgr::instance().GetPlayerbotAI(player))
+    if (HasPlayerbotAI(player))
         return; // Only real players
     if (!g_GuildEventTypeGuildLogin.empty())
         eventChatter.DispatchGameEvent(player, g_GuildEventTypeGuildLogin, guild->GetName());
@@ -15,14 +15,18 @@
 #include "ChannelMgr.h"
 #include <sstream>
 #include <vector>
+#include <list>
 #include <fmt/core.h>
 #include <nlohmann/json.hpp>
 #include <thread>
+#include <memory>
 #include <algorithm>
 #include <random>
 #include <cctype>
 #include <chrono>
 #include <ctime>
+#include <array>
+#include <cmath>
 #include "DatabaseEnv.h"
 #include "mod-ollama-chat_handler.h"
 #include "mod-ollama-chat_api.h"
@@ -31,6 +35,9 @@
 #include "mod-ollama-chat-utilities.h"
 #include "mod-ollama-chat_sentiment.h"
 #include "mod-ollama-chat_rag.h"
+#include "mod-ollama-chat_presence.h"
+#include "mod-ollama-chat_mention.h"
+#include "mod-ollama-chat_outbox.h"
 #include <iomanip>
 #include "SpellMgr.h"
 #include "SpellInfo.h"
@@ -52,7 +59,6 @@
 // Forward declarations for internal helper functions.
 static bool IsBotEligibleForChatChannelLocal(Player* bot, Player* player,
                                              ChatChannelSourceLocal source, Channel* channel = nullptr, Player* receiver = nullptr);
-static std::string GenerateBotPrompt(Player* bot, std::string playerMessage, Player* player);
 
 // Helper function to format class name for any player
 static std::string FormatPlayerClass(uint8_t classId)
@@ -224,14 +230,12 @@ bool PlayerBotChatHandler::OnPlayerCanUseChat(Player* player, uint32_t type, uin
             return true;
 
         // Check if sender is a bot - if so, don't trigger Ollama responses for bot-to-bot whispers
-        PlayerbotAI* senderAI = PlayerbotsMgr::instance().GetPlayerbotAI(player);
-        if (senderAI && senderAI->IsBotAI())
+        if (IsBotPlayer(player))
         {
             return true;
         }
 
-        PlayerbotAI* receiverAI = PlayerbotsMgr::instance().GetPlayerbotAI(receiver);
-        if (!receiverAI || !receiverAI->IsBotAI())
+        if (!IsBotPlayer(receiver))
             return true;
     }
 
@@ -360,20 +364,7 @@ void ProcessBotChatMessage(Player* bot, const std::string& msg, ChatChannelSourc
                 if (guild)
                 {
                     // Check if any real (non-bot) players are online in this guild
-                    bool hasRealPlayer = false;
-                    for (auto const& pair : ObjectAccessor::GetPlayers())
-                    {
-                        Player* member = pair.second;
-                        if (member && member->GetGuildId() == bot->GetGuildId())
-                        {
-                            if (!PlayerbotsMgr::instance().GetPlayerbotAI(member))
-                            {
-                                hasRealPlayer = true;
-                                break;
-                            }
-                        }
-                    }
-                    canSendMessage = hasRealPlayer;
+                    canSendMessage = g_PresenceIndex.HasRealPlayerInGuild(bot->GetGuildId());
                     if (!canSendMessage && g_DebugEnabled)
                         LOG_INFO("server.loading", "[Ollama Chat] Bot {} cannot send to Guild - no real players online in guild", bot->GetName());
                 }
@@ -402,7 +393,7 @@ void ProcessBotChatMessage(Player* bot, const std::string& msg, ChatChannelSourc
                 for (GroupReference* ref = group->GetFirstMember(); ref; ref = ref->next())
                 {
                     Player* member = ref->GetSource();
-                    if (member && !PlayerbotsMgr::instance().GetPlayerbotAI(member))
+                    if (member && !HasPlayerbotAI(member))
                     {
                         hasRealPlayer = true;
                         break;
@@ -460,9 +451,9 @@ void ProcessBotChatMessage(Player* bot, const std::string& msg, ChatChannelSourc
     PlayerBotChatHandler::ProcessChat(bot, type, lang, mutableMsg, sourceLocal, channel, nullptr);
 }
 
-std::string GetBotHistoryPrompt(uint64_t botGuid, uint64_t playerGuid, std::string playerMessage)
+std::string GetBotHistoryPrompt(const OllamaPromptConfig& config, uint64_t botGuid, uint64_t playerGuid, const std::string& playerName, std::string playerMessage)
 {
-    if(!g_EnableChatHistory)
+    if(!config.enableChatHistory)
     {
         return "";
     }
@@ -477,20 +468,17 @@ std::string GetBotHistoryPrompt(uint64_t botGuid, uint64_t playerGuid, std::stri
     if (playerIt == botIt->second.end())
         return result;
 
-    Player* player = ObjectAccessor::FindPlayer(ObjectGuid(playerGuid));
-    std::string playerName = player ? player->GetName() : "The player";
-
-    result += SafeFormat(g_ChatHistoryHeaderTemplate, fmt::arg("player_name", playerName));
+    result += SafeFormat(config.chatHistoryHeaderTemplate, fmt::arg("player_name", playerName));
 
     for (const auto& entry : playerIt->second) {
-        result += SafeFormat(g_ChatHistoryLineTemplate,
+        result += SafeFormat(config.chatHistoryLineTemplate,
             fmt::arg("player_name", playerName),
             fmt::arg("player_message", entry.first),
             fmt::arg("bot_reply", entry.second)
         );
     }
 
-    result += SafeFormat(g_ChatHistoryFooterTemplate,
+    result += SafeFormat(config.chatHistoryFooterTemplate,
         fmt::arg("player_name", playerName),
         fmt::arg("player_message", playerMessage)
     );
@@ -498,12 +486,152 @@ std::string GetBotHistoryPrompt(uint64_t botGuid, uint64_t playerGuid, std::stri
     return result;
 }
 
-// --- Helper: Spells ---
-std::string ChatHandler_GetBotSpellInfo(Player* bot)
+// Chat-endpoint counterpart of GetBotHistoryPrompt: the stored turns as
+// user/assistant messages, copied without any template formatting.
+std::vector<OllamaMessage> GetBotHistoryMessages(const OllamaPromptConfig& config, uint64_t botGuid, uint64_t playerGuid)
 {
-    // Map to store highest rank of each spell: spell name -> (spellId, rank, costText)
-    std::map<std::string, std::tuple<uint32, uint32, std::string>> uniqueSpells;
-    
+    std::vector<OllamaMessage> messages;
+    if(!config.enableChatHistory)
+    {
+        return messages;
+    }
+
+    std::lock_guard<std::mutex> lock(g_ConversationHistoryMutex);
+
+    const auto botIt = g_BotConversationHistory.find(botGuid);
+    if (botIt == g_BotConversationHistory.end())
+        return messages;
+    const auto playerIt = botIt->second.find(playerGuid);
+    if (playerIt == botIt->second.end())
+        return messages;
+
+    messages.reserve(playerIt->second.size() * 2);
+    for (const auto& entry : playerIt->second) {
+        messages.push_back({ "user", entry.first });
+        messages.push_back({ "assistant", entry.second });
+    }
+    return messages;
+}
+
+// --- Game state snapshot ---
+// The world thread only copies what the snapshot template needs into these
+// plain structs; turning them into text happens on the query worker.
+struct SnapshotUnitInfo
+{
+    std::string name;
+    uint32 level = 0;
+    uint32 health = 0;
+    uint32 maxHealth = 0;
+};
+
+struct SnapshotGroupMember
+{
+    SnapshotUnitInfo unit;
+    uint8 classId = 0;
+    uint8 raceId = 0;
+    float distance = 0.0f;
+    bool underAttack = false;
+    SnapshotUnitInfo attacker;
+};
+
+struct SnapshotSpell
+{
+    uint32 rank = 0;
+    uint32 powerType = 0;
+    uint32 cost = 0;
+    bool hasCost = false;
+};
+
+struct SnapshotQuest
+{
+    std::string title;
+    QuestStatus status = QUEST_STATUS_NONE;
+};
+
+struct SnapshotCreature
+{
+    std::string type;
+    SnapshotUnitInfo unit;
+    float distance = 0.0f;
+};
+
+struct SnapshotGameObject
+{
+    std::string name;
+    uint32 type = 0;
+    float distance = 0.0f;
+};
+
+struct SnapshotPlayer
+{
+    std::string name;
+    uint32 level = 0;
+    uint8 classId = 0;
+    uint8 raceId = 0;
+    bool alliance = false;
+    float distance = 0.0f;
+};
+
+struct BotGameStateSnapshot
+{
+    bool inCombat = false;
+    bool hasVictim = false;
+    SnapshotUnitInfo victim;
+    const char* resourceName = nullptr; // class resource to report, if any
+    uint32 resource = 0;
+    uint32 maxResource = 0;
+    std::vector<SnapshotGroupMember> group;
+    std::vector<std::pair<std::string, SnapshotSpell>> spells; // by spell name, highest ready rank only
+    std::vector<SnapshotQuest> quests;
+    std::vector<SnapshotCreature> creatures;
+    std::vector<SnapshotGameObject> gameObjects;
+    std::vector<SnapshotPlayer> players;
+};
+
+static SnapshotUnitInfo CaptureUnitInfo(Unit* unit)
+{
+    SnapshotUnitInfo info;
+    info.name = unit->GetName();
+    info.level = unit->GetLevel();
+    info.health = unit->GetHealth();
+    info.maxHealth = unit->GetMaxHealth();
+    return info;
+}
+
+// --- Per-bot snapshot cache ---
+// The spell book and quest titles barely change between prompts, so they are
+// kept per bot instead of being rebuilt from the spell map and locale tables
+// every time. OllamaSnapshotCacheTracker marks the spells dirty when the bot
+// learns or forgets a spell or levels. Cooldowns and quest statuses change
+// without a hook and are read live.
+struct CachedBotSpell
+{
+    uint32 spellId = 0;
+    std::string name;
+    SnapshotSpell spell;
+};
+
+struct BotSnapshotCache
+{
+    bool spellsValid = false;
+    std::vector<CachedBotSpell> spells;                 // by name, highest rank first
+    std::unordered_map<uint32, std::string> questTitles; // localized, by quest id
+};
+
+static std::mutex s_SnapshotCacheMutex;
+static std::unordered_map<uint64_t, BotSnapshotCache> s_SnapshotCache;
+
+static void InvalidateBotSpellCache(Player* player)
+{
+    std::lock_guard<std::mutex> lock(s_SnapshotCacheMutex);
+    auto it = s_SnapshotCache.find(player->GetGUID().GetRawValue());
+    if (it != s_SnapshotCache.end())
+        it->second.spellsValid = false;
+}
+
+static void RebuildBotSpellCache(Player* bot, BotSnapshotCache& cache)
+{
+    cache.spells.clear();
     for (const auto& spellPair : bot->GetSpellMap())
     {
         uint32 spellId = spellPair.first;
@@ -512,99 +640,204 @@ std::string ChatHandler_GetBotSpellInfo(Player* bot)
             continue;
         if (spellInfo->SpellFamilyName == SPELLFAMILY_GENERIC)
             continue;
-        if (bot->HasSpellCooldown(spellId))
-            continue;
-        
+
         const char* name = spellInfo->SpellName[0];
         if (!name || !*name)
             continue;
-        
+
+        CachedBotSpell entry;
+        entry.spellId = spellId;
+        entry.name = name;
+        entry.spell.rank = spellInfo->GetRank();
+        entry.spell.powerType = spellInfo->PowerType;
+        entry.spell.cost = spellInfo->ManaCost;
+        entry.spell.hasCost = spellInfo->ManaCost || spellInfo->ManaCostPercentage;
+        cache.spells.push_back(std::move(entry));
+    }
+    std::sort(cache.spells.begin(), cache.spells.end(), [](const CachedBotSpell& a, const CachedBotSpell& b) {
+        if (a.name != b.name)
+            return a.name < b.name;
+        return a.spell.rank > b.spell.rank;
+    });
+    cache.spellsValid = true;
+}
+
+OllamaSnapshotCacheTracker::OllamaSnapshotCacheTracker() : PlayerScript("OllamaSnapshotCacheTracker") {}
+
+void OllamaSnapshotCacheTracker::OnPlayerLearnSpell(Player* player, uint32 /*spellID*/)
+{
+    InvalidateBotSpellCache(player);
+}
+
+void OllamaSnapshotCacheTracker::OnPlayerForgotSpell(Player* player, uint32 /*spellID*/)
+{
+    InvalidateBotSpellCache(player);
+}
+
+void OllamaSnapshotCacheTracker::OnPlayerLevelChanged(Player* player, uint8 /*oldLevel*/)
+{
+    InvalidateBotSpellCache(player);
+}
+
+void OllamaSnapshotCacheTracker::OnPlayerLogout(Player* player)
+{
+    std::lock_guard<std::mutex> lock(s_SnapshotCacheMutex);
+    s_SnapshotCache.erase(player->GetGUID().GetRawValue());
+}
+
+// --- Helper: Spells ---
+static void CaptureBotSpells(Player* bot, BotGameStateSnapshot& snapshot)
+{
+    std::lock_guard<std::mutex> lock(s_SnapshotCacheMutex);
+    BotSnapshotCache& cache = s_SnapshotCache[bot->GetGUID().GetRawValue()];
+    if (!cache.spellsValid)
+        RebuildBotSpellCache(bot, cache);
+
+    // Only keep the highest rank of each spell that is not on cooldown
+    for (const CachedBotSpell& entry : cache.spells)
+    {
+        if (!snapshot.spells.empty() && snapshot.spells.back().first == entry.name)
+            continue;
+        if (bot->HasSpellCooldown(entry.spellId))
+            continue;
+        snapshot.spells.emplace_back(entry.name, entry.spell);
+    }
+}
+
+std::string ChatHandler_FormatBotSpellInfo(const BotGameStateSnapshot& snapshot)
+{
+    // Build the output string from unique spells
+    std::ostringstream spellSummary;
+    for (const auto& [spellName, spell] : snapshot.spells)
+    {
         std::string costText;
-        if (spellInfo->ManaCost || spellInfo->ManaCostPercentage)
+        if (spell.hasCost)
         {
-            switch (spellInfo->PowerType)
+            switch (spell.powerType)
             {
-                case POWER_MANA: costText = std::to_string(spellInfo->ManaCost) + " mana"; break;
-                case POWER_RAGE: costText = std::to_string(spellInfo->ManaCost) + " rage"; break;
-                case POWER_FOCUS: costText = std::to_string(spellInfo->ManaCost) + " focus"; break;
-                case POWER_ENERGY: costText = std::to_string(spellInfo->ManaCost) + " energy"; break;
-                case POWER_RUNIC_POWER: costText = std::to_string(spellInfo->ManaCost) + " runic power"; break;
-                default: costText = std::to_string(spellInfo->ManaCost) + " unknown resource"; break;
+                case POWER_MANA: costText = std::to_string(spell.cost) + " mana"; break;
+                case POWER_RAGE: costText = std::to_string(spell.cost) + " rage"; break;
+                case POWER_FOCUS: costText = std::to_string(spell.cost) + " focus"; break;
+                case POWER_ENERGY: costText = std::to_string(spell.cost) + " energy"; break;
+                case POWER_RUNIC_POWER: costText = std::to_string(spell.cost) + " runic power"; break;
+                default: costText = std::to_string(spell.cost) + " unknown resource"; break;
             }
         }
         else
         {
             costText = "no cost";
         }
-        
-        // Get base spell name (without rank)
-        std::string spellName = name;
-        uint32 rank = spellInfo->GetRank();
-        
-        // Check if we already have this spell, and if so, only keep the highest rank
-        auto it = uniqueSpells.find(spellName);
-        if (it == uniqueSpells.end())
+
+        spellSummary << "**" << spellName << "**";
+        if (spell.rank > 0)
         {
-            // First time seeing this spell
-            uniqueSpells[spellName] = std::make_tuple(spellId, rank, costText);
+            spellSummary << " (Rank " << spell.rank << ")";
         }
-        else
+        spellSummary << " - Costs " << costText << "\n";
+    }
+    return spellSummary.str();
+}
+
+// --- Helper: Quests ---
+static void CaptureBotQuests(Player* bot, BotGameStateSnapshot& snapshot)
+{
+    std::lock_guard<std::mutex> lock(s_SnapshotCacheMutex);
+    BotSnapshotCache& cache = s_SnapshotCache[bot->GetGUID().GetRawValue()];
+    for (auto const& [questId, qsd] : bot->getQuestStatusMap())
+    {
+        auto titleIt = cache.questTitles.find(questId);
+        if (titleIt == cache.questTitles.end())
         {
-            // We've seen this spell before, check if this is a higher rank
-            uint32 existingRank = std::get<1>(it->second);
-            if (rank > existingRank)
+            // look up the template
+            Quest const* quest = sObjectMgr->GetQuestTemplate(questId);
+            if (!quest)
+                continue;
+
+            // get the English title as a fallback
+            std::string title = quest->GetTitle();
+
+            // then, if we have a locale record, overwrite it
+            if (auto const* locale = sObjectMgr->GetQuestLocale(questId))
             {
-                // Replace with higher rank
-                uniqueSpells[spellName] = std::make_tuple(spellId, rank, costText);
+                int locIdx = bot->GetSession()->GetSessionDbLocaleIndex();
+                if (locIdx >= 0)
+                    ObjectMgr::GetLocaleString(locale->Title, locIdx, title);
             }
+
+            titleIt = cache.questTitles.emplace(questId, std::move(title)).first;
         }
+
+        snapshot.quests.push_back({ titleIt->second, qsd.Status });
     }
-    
-    // Build the output string from unique spells
-    std::ostringstream spellSummary;
-    for (const auto& [spellName, spellData] : uniqueSpells)
+}
+
+std::string ChatHandler_FormatBotQuests(const BotGameStateSnapshot& snapshot)
+{
+    std::string quests;
+    for (const SnapshotQuest& quest : snapshot.quests)
     {
-        uint32 rank = std::get<1>(spellData);
-        const std::string& costText = std::get<2>(spellData);
-        
-        spellSummary << "**" << spellName << "**";
-        if (rank > 0)
+        // Convert quest status to readable string
+        std::string statusText;
+        switch (quest.status)
         {
-            spellSummary << " (Rank " << rank << ")";
+            case QUEST_STATUS_NONE:       statusText = "not started"; break;
+            case QUEST_STATUS_COMPLETE:   statusText = "complete (ready to turn in)"; break;
+            case QUEST_STATUS_INCOMPLETE: statusText = "in progress"; break;
+            case QUEST_STATUS_FAILED:     statusText = "failed"; break;
+            case QUEST_STATUS_REWARDED:   statusText = "completed and rewarded"; break;
+            default:                      statusText = "unknown"; break;
         }
-        spellSummary << " - Costs " << costText << "\n";
+
+        quests += "Quest \"" + quest.title + "\" is " + statusText + "\n";
     }
-    return spellSummary.str();
+    return quests;
 }
 
 // --- Helper: Group info ---
-std::vector<std::string> ChatHandler_GetGroupStatus(Player* bot)
+static void CaptureGroupStatus(Player* bot, BotGameStateSnapshot& snapshot)
 {
-    std::vector<std::string> info;
-    if (!bot || !bot->GetGroup()) return info;
+    if (!bot || !bot->GetGroup()) return;
     Group* group = bot->GetGroup();
     for (GroupReference* ref = group->GetFirstMember(); ref; ref = ref->next())
     {
         Player* member = ref->GetSource();
         if (!member || !member->GetMap()) continue;
         if(bot == member) continue;
-        float dist = bot->GetDistance(member);
-        std::string beingAttacked = "";
+        SnapshotGroupMember info;
+        info.unit = CaptureUnitInfo(member);
+        info.classId = member->getClass();
+        info.raceId = member->getRace();
+        info.distance = bot->GetDistance(member);
         if (Unit* attacker = member->GetVictim())
         {
-            beingAttacked = " [Under Attack by " + attacker->GetName() +
-                            ", Level: " + std::to_string(attacker->GetLevel()) + ", HP: " + std::to_string(attacker->GetHealth()) +
-                            "/" + std::to_string(attacker->GetMaxHealth()) + ")]";
+            info.underAttack = true;
+            info.attacker = CaptureUnitInfo(attacker);
+        }
+        snapshot.group.push_back(std::move(info));
+    }
+}
+
+std::vector<std::string> ChatHandler_FormatGroupStatus(const BotGameStateSnapshot& snapshot)
+{
+    std::vector<std::string> info;
+    for (const SnapshotGroupMember& member : snapshot.group)
+    {
+        std::string beingAttacked = "";
+        if (member.underAttack)
+        {
+            beingAttacked = " [Under Attack by " + member.attacker.name +
+                            ", Level: " + std::to_string(member.attacker.level) + ", HP: " + std::to_string(member.attacker.health) +
+                            "/" + std::to_string(member.attacker.maxHealth) + ")]";
         }
-        std::string className = FormatPlayerClass(member->getClass());
-        std::string raceName = FormatPlayerRace(member->getRace());
+        std::string className = FormatPlayerClass(member.classId);
+        std::string raceName = FormatPlayerRace(member.raceId);
         info.push_back(
-            member->GetName() +
-            " (Level: " + std::to_string(member->GetLevel()) +
+            member.unit.name +
+            " (Level: " + std::to_string(member.unit.level) +
             ", Class: " + className +
             ", Race: " + raceName +
-            ", HP: " + std::to_string(member->GetHealth()) + "/" + std::to_string(member->GetMaxHealth()) +
-            ", Dist: " + std::to_string(dist) + ")" + beingAttacked
+            ", HP: " + std::to_string(member.unit.health) + "/" + std::to_string(member.unit.maxHealth) +
+            ", Dist: " + std::to_string(member.distance) + ")" + beingAttacked
         );
 
     }
@@ -612,29 +845,108 @@ std::vector<std::string> ChatHandler_GetGroupStatus(Player* bot)
 }
 
 // --- Helper: Visible players ---
-std::vector<std::string> ChatHandler_GetVisiblePlayers(Player* bot, float radius = 40.0f)
+// Line-of-sight results between two players, kept for a moment. LOS does not
+// depend on direction, so the pair is keyed by the lower GUID counter first:
+// when several nearby bots answer the same message, bot A's check of bot B is
+// reused for B's check of A. A result only counts while both players are still
+// where they were when it was taken.
+struct LosCacheEntry
 {
-    std::vector<std::string> players;
-    if (!bot || !bot->GetMap()) return players;
-    for (auto const& pair : ObjectAccessor::GetPlayers())
+    bool visible = false;
+    std::chrono::steady_clock::time_point expires;
+    std::array<int32_t, 3> lowPosition;  // position of the player with the lower counter
+    std::array<int32_t, 3> highPosition;
+};
+
+static constexpr std::chrono::milliseconds LOS_CACHE_TTL(1000);
+static constexpr size_t LOS_CACHE_PRUNE_SIZE = 4096;
+static constexpr float LOS_CACHE_POSITION_QUANTUM = 1.0f; // yards
+static std::mutex s_LosCacheMutex;
+static std::unordered_map<uint64_t, LosCacheEntry> s_LosCache; // lower counter << 32 | higher counter
+
+static std::array<int32_t, 3> QuantizeLosPosition(Player* player)
+{
+    return { static_cast<int32_t>(std::floor(player->GetPositionX() / LOS_CACHE_POSITION_QUANTUM)),
+             static_cast<int32_t>(std::floor(player->GetPositionY() / LOS_CACHE_POSITION_QUANTUM)),
+             static_cast<int32_t>(std::floor(player->GetPositionZ() / LOS_CACHE_POSITION_QUANTUM)) };
+}
+
+static bool IsPlayerInLOSCached(Player* bot, Player* player)
+{
+    uint32_t botCounter = bot->GetGUID().GetCounter();
+    uint32_t playerCounter = player->GetGUID().GetCounter();
+    Player* low = botCounter < playerCounter ? bot : player;
+    Player* high = botCounter < playerCounter ? player : bot;
+    uint64_t key = (uint64_t(std::min(botCounter, playerCounter)) << 32) | std::max(botCounter, playerCounter);
+    std::array<int32_t, 3> lowPosition = QuantizeLosPosition(low);
+    std::array<int32_t, 3> highPosition = QuantizeLosPosition(high);
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(s_LosCacheMutex);
+        auto it = s_LosCache.find(key);
+        if (it != s_LosCache.end() && it->second.expires > now &&
+            it->second.lowPosition == lowPosition && it->second.highPosition == highPosition)
+            return it->second.visible;
+    }
+
+    bool visible = bot->IsWithinLOS(player->GetPositionX(), player->GetPositionY(), player->GetPositionZ());
+
+    std::lock_guard<std::mutex> lock(s_LosCacheMutex);
+    if (s_LosCache.size() >= LOS_CACHE_PRUNE_SIZE)
+    {
+        for (auto it = s_LosCache.begin(); it != s_LosCache.end();)
+        {
+            if (it->second.expires <= now)
+                it = s_LosCache.erase(it);
+            else
+                ++it;
+        }
+    }
+    s_LosCache[key] = { visible, now + LOS_CACHE_TTL, lowPosition, highPosition };
+    return visible;
+}
+
+static void CaptureVisiblePlayers(Player* bot, BotGameStateSnapshot& snapshot, float radius = 40.0f)
+{
+    if (!bot || !bot->GetMap()) return;
+
+    // Only the grid cells around the bot are searched
+    std::list<Player*> nearbyPlayers;
+    Acore::AnyPlayerInObjectRangeCheck check(bot, radius, false);
+    Acore::PlayerListSearcher<Acore::AnyPlayerInObjectRangeCheck> searcher(bot, nearbyPlayers, check);
+    Cell::VisitWorldObjects(bot, searcher, radius);
+
+    for (Player* player : nearbyPlayers)
     {
-        Player* player = pair.second;
         if (!player || player == bot) continue;
         if (!player->IsInWorld() || player->IsGameMaster()) continue;
-        if (player->GetMap() != bot->GetMap()) continue;
-        if (!bot->IsWithinDistInMap(player, radius)) continue;
-        if (!bot->IsWithinLOS(player->GetPositionX(), player->GetPositionY(), player->GetPositionZ())) continue;
-        float dist = bot->GetDistance(player);
-        std::string faction = (player->GetTeamId() == TEAM_ALLIANCE ? "Alliance" : "Horde");
-        std::string className = FormatPlayerClass(player->getClass());
-        std::string raceName = FormatPlayerRace(player->getRace());
+        if (!IsPlayerInLOSCached(bot, player)) continue;
+        SnapshotPlayer info;
+        info.name = player->GetName();
+        info.level = player->GetLevel();
+        info.classId = player->getClass();
+        info.raceId = player->getRace();
+        info.alliance = player->GetTeamId() == TEAM_ALLIANCE;
+        info.distance = bot->GetDistance(player);
+        snapshot.players.push_back(std::move(info));
+    }
+}
+
+std::vector<std::string> ChatHandler_FormatVisiblePlayers(const BotGameStateSnapshot& snapshot)
+{
+    std::vector<std::string> players;
+    for (const SnapshotPlayer& player : snapshot.players)
+    {
+        std::string faction = (player.alliance ? "Alliance" : "Horde");
+        std::string className = FormatPlayerClass(player.classId);
+        std::string raceName = FormatPlayerRace(player.raceId);
         players.push_back(
-            "Player: " + player->GetName() +
-            " (Level: " + std::to_string(player->GetLevel()) +
+            "Player: " + player.name +
+            " (Level: " + std::to_string(player.level) +
             ", Class: " + className +
             ", Race: " + raceName +
             ", Faction: " + faction +
-            ", Distance: " + std::to_string(dist) + ")"
+            ", Distance: " + std::to_string(player.distance) + ")"
         );
 
     }
@@ -642,88 +954,128 @@ std::vector<std::string> ChatHandler_GetVisiblePlayers(Player* bot, float radius
 }
 
 // --- Helper: Visible locations/objects (creatures and gameobjects) ---
-std::vector<std::string> ChatHandler_GetVisibleLocations(Player* bot, float radius = 40.0f)
+static void CaptureVisibleLocations(Player* bot, BotGameStateSnapshot& snapshot, float radius = 40.0f)
+{
+    if (!bot || !bot->GetMap()) return;
+
+    // Only the grid cells around the bot are searched
+    std::list<WorldObject*> objects;
+    Acore::AllWorldObjectsInRange check(bot, radius);
+    Acore::WorldObjectListSearcher<Acore::AllWorldObjectsInRange> searcher(bot, objects, check,
+        GRID_MAP_TYPE_MASK_CREATURE | GRID_MAP_TYPE_MASK_GAMEOBJECT);
+    Cell::VisitGridObjects(bot, searcher, radius);
+
+    std::vector<std::pair<float, WorldObject*>> nearby;
+    nearby.reserve(objects.size());
+    for (WorldObject* object : objects)
+    {
+        if (object == bot) continue;
+        if (Creature* c = object->ToCreature())
+        {
+            if (c->IsPet() || c->IsTotem()) continue;
+        }
+        float distance = bot->GetDistance(object);
+        if (distance > radius) continue;
+        nearby.emplace_back(distance, object);
+    }
+
+    // Line of sight is the expensive part, so only the nearest few are checked
+    size_t limit = std::min<size_t>(nearby.size(), g_SnapshotMaxVisibleObjects);
+    std::partial_sort(nearby.begin(), nearby.begin() + limit, nearby.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    for (size_t i = 0; i < limit; ++i)
+    {
+        auto [distance, object] = nearby[i];
+        if (!bot->IsWithinLOS(object->GetPositionX(), object->GetPositionY(), object->GetPositionZ())) continue;
+        if (Creature* c = object->ToCreature())
+        {
+            SnapshotCreature info;
+            if (c->isDead()) info.type = "DEAD";
+            else if (c->IsHostileTo(bot)) info.type = "ENEMY";
+            else if (c->IsFriendlyTo(bot)) info.type = "FRIENDLY";
+            else info.type = "NEUTRAL";
+            info.unit = CaptureUnitInfo(c);
+            info.distance = distance;
+            snapshot.creatures.push_back(std::move(info));
+        }
+        else if (GameObject* go = object->ToGameObject())
+        {
+            snapshot.gameObjects.push_back({ go->GetName(), static_cast<uint32>(go->GetGoType()), distance });
+        }
+    }
+}
+
+std::vector<std::string> ChatHandler_FormatVisibleLocations(const BotGameStateSnapshot& snapshot)
 {
     std::vector<std::string> visible;
-    if (!bot || !bot->GetMap()) return visible;
-    Map* map = bot->GetMap();
-    for (auto const& pair : map->GetCreatureBySpawnIdStore())
-    {
-        Creature* c = pair.second;
-        if (!c) continue;
-        if (c->GetGUID() == bot->GetGUID()) continue;
-        if (!bot->IsWithinDistInMap(c, radius)) continue;
-        if (!bot->IsWithinLOS(c->GetPositionX(), c->GetPositionY(), c->GetPositionZ())) continue;
-        if (c->IsPet() || c->IsTotem()) continue;
-        std::string type;
-        if (c->isDead()) type = "DEAD";
-        else if (c->IsHostileTo(bot)) type = "ENEMY";
-        else if (c->IsFriendlyTo(bot)) type = "FRIENDLY";
-        else type = "NEUTRAL";
-        float dist = bot->GetDistance(c);
+    for (const SnapshotCreature& c : snapshot.creatures)
+    {
         visible.push_back(
-            type + ": " + c->GetName() +
-            ", Level: " + std::to_string(c->GetLevel()) +
-            ", HP: " + std::to_string(c->GetHealth()) + "/" + std::to_string(c->GetMaxHealth()) +
-            ", Distance: " + std::to_string(dist) + ")"
+            c.type + ": " + c.unit.name +
+            ", Level: " + std::to_string(c.unit.level) +
+            ", HP: " + std::to_string(c.unit.health) + "/" + std::to_string(c.unit.maxHealth) +
+            ", Distance: " + std::to_string(c.distance) + ")"
         );
     }
-    for (auto const& pair : map->GetGameObjectBySpawnIdStore())
+    for (const SnapshotGameObject& go : snapshot.gameObjects)
     {
-        GameObject* go = pair.second;
-        if (!go) continue;
-        if (!bot->IsWithinDistInMap(go, radius)) continue;
-        if (!bot->IsWithinLOS(go->GetPositionX(), go->GetPositionY(), go->GetPositionZ())) continue;
-        float dist = bot->GetDistance(go);
         visible.push_back(
-            go->GetName() +
-            ", Type: " + std::to_string(go->GetGoType()) +
-            ", Distance: " + std::to_string(dist) + ")"
+            go.name +
+            ", Type: " + std::to_string(go.type) +
+            ", Distance: " + std::to_string(go.distance) + ")"
         );
     }
     return visible;
 }
 
 // --- Helper: Combat summary ---
-std::string ChatHandler_GetCombatSummary(Player* bot)
+static void CaptureCombatSummary(Player* bot, BotGameStateSnapshot& snapshot)
 {
-    std::ostringstream oss;
-    bool inCombat = bot->IsInCombat();
-    Unit* victim = bot->GetVictim();
+    snapshot.inCombat = bot->IsInCombat();
+    if (Unit* victim = bot->GetVictim())
+    {
+        snapshot.hasVictim = true;
+        snapshot.victim = CaptureUnitInfo(victim);
+    }
 
     // Class-specific resource reporting
-    auto classId = bot->getClass();
+    Powers power = POWER_MANA;
+    switch (bot->getClass())
+    {
+        case CLASS_WARRIOR:      power = POWER_RAGE;        snapshot.resourceName = "Rage"; break;
+        case CLASS_ROGUE:        power = POWER_ENERGY;      snapshot.resourceName = "Energy"; break;
+        case CLASS_DEATH_KNIGHT: power = POWER_RUNIC_POWER; snapshot.resourceName = "Runic Power"; break;
+        case CLASS_HUNTER:       power = POWER_FOCUS;       snapshot.resourceName = "Focus"; break;
+        default: // Mana classes
+            if (bot->GetMaxPower(POWER_MANA) > 0)
+                snapshot.resourceName = "Mana";
+            break;
+    }
+    if (snapshot.resourceName)
+    {
+        snapshot.resource = bot->GetPower(power);
+        snapshot.maxResource = bot->GetMaxPower(power);
+    }
+}
+
+std::string ChatHandler_FormatCombatSummary(const BotGameStateSnapshot& snapshot)
+{
+    std::ostringstream oss;
 
     auto printResource = [&](std::ostringstream& oss) {
-        switch (classId)
-        {
-            case CLASS_WARRIOR:
-                oss << ", Rage: " << bot->GetPower(POWER_RAGE) << "/" << bot->GetMaxPower(POWER_RAGE);
-                break;
-            case CLASS_ROGUE:
-                oss << ", Energy: " << bot->GetPower(POWER_ENERGY) << "/" << bot->GetMaxPower(POWER_ENERGY);
-                break;
-            case CLASS_DEATH_KNIGHT:
-                oss << ", Runic Power: " << bot->GetPower(POWER_RUNIC_POWER) << "/" << bot->GetMaxPower(POWER_RUNIC_POWER);
-                break;
-            case CLASS_HUNTER:
-                oss << ", Focus: " << bot->GetPower(POWER_FOCUS) << "/" << bot->GetMaxPower(POWER_FOCUS);
-                break;
-            default: // Mana classes
-                if (bot->GetMaxPower(POWER_MANA) > 0)
-                    oss << ", Mana: " << bot->GetPower(POWER_MANA) << "/" << bot->GetMaxPower(POWER_MANA);
-                break;
-        }
+        if (snapshot.resourceName)
+            oss << ", " << snapshot.resourceName << ": " << snapshot.resource << "/" << snapshot.maxResource;
     };
 
-    if (inCombat)
+    if (snapshot.inCombat)
     {
         oss << "IN COMBAT: ";
-        if (victim)
+        if (snapshot.hasVictim)
         {
-            oss << "Target: " << victim->GetName()
-                << ", Level: " << victim->GetLevel()
-                << ", HP: " << victim->GetHealth() << "/" << victim->GetMaxHealth();
+            oss << "Target: " << snapshot.victim.name
+                << ", Level: " << snapshot.victim.level
+                << ", HP: " << snapshot.victim.health << "/" << snapshot.victim.maxHealth;
         }
         else
         {
@@ -740,80 +1092,331 @@ std::string ChatHandler_GetCombatSummary(Player* bot)
     return oss.str();
 }
 
+// World thread: copy everything the snapshot template uses out of the game objects.
+static BotGameStateSnapshot CaptureBotGameStateSnapshot(Player* bot)
+{
+    BotGameStateSnapshot snapshot;
+    CaptureCombatSummary(bot, snapshot);
+    CaptureGroupStatus(bot, snapshot);
+    CaptureBotSpells(bot, snapshot);
+    CaptureBotQuests(bot, snapshot);
+    CaptureVisibleLocations(bot, snapshot);
+    CaptureVisiblePlayers(bot, snapshot);
+    return snapshot;
+}
 
-static std::string GenerateBotGameStateSnapshot(Player* bot)
+// Query worker: render a captured snapshot through the snapshot template.
+static std::string FormatBotGameStateSnapshot(const std::string& snapshotTemplate, const BotGameStateSnapshot& snapshot)
 {
     // Prepare each section
-    std::string combat = ChatHandler_GetCombatSummary(bot);
+    std::string combat = ChatHandler_FormatCombatSummary(snapshot);
 
     std::string group;
-    std::vector<std::string> groupInfo = ChatHandler_GetGroupStatus(bot);
+    std::vector<std::string> groupInfo = ChatHandler_FormatGroupStatus(snapshot);
     if (!groupInfo.empty()) {
         group += "Group members:\n";
         for (const auto& entry : groupInfo) group += " - " + entry + "\n";
     }
 
-    std::string spells = ChatHandler_GetBotSpellInfo(bot);
+    std::string spells = ChatHandler_FormatBotSpellInfo(snapshot);
 
-    std::string quests;
-    for (auto const& [questId, qsd] : bot->getQuestStatusMap())
+    std::string quests = ChatHandler_FormatBotQuests(snapshot);
+
+    std::string los;
+    std::vector<std::string> losLocs = ChatHandler_FormatVisibleLocations(snapshot);
+    if (!losLocs.empty()) {
+        for (const auto& entry : losLocs) los += " - " + entry + "\n";
+    }
+
+    std::string players;
+    std::vector<std::string> nearbyPlayers = ChatHandler_FormatVisiblePlayers(snapshot);
+    if (!nearbyPlayers.empty()) {
+        for (const auto& entry : nearbyPlayers) players += " - " + entry + "\n";
+    }
+
+    // Use template
+    return SafeFormat(
+        snapshotTemplate,
+        fmt::arg("combat", combat),
+        fmt::arg("group", group),
+        fmt::arg("spells", spells),
+        fmt::arg("quests", quests),
+        fmt::arg("los", los),
+        fmt::arg("players", players)
+    );
+}
+
+
+// Everything the prompt needs from the bot and the player, copied on the world
+// thread so the prompt can be built on the query worker without touching Player.
+struct BotPromptSnapshot
+{
+    bool valid = false;
+    // Settings as of the capture; .ollama reload swaps in a new copy
+    std::shared_ptr<const OllamaPromptConfig> config;
+    uint64_t botGuid = 0;
+    uint64_t playerGuid = 0;
+    std::string playerMessage;
+
+    std::string personality;
+    std::string personalityPrompt;
+    std::string botName;
+    uint32_t botLevel = 0;
+    std::string botAreaName;
+    std::string botZoneName;
+    std::string botMapName;
+    std::string botClass;
+    std::string botRace;
+    std::string botRole;
+    std::string botGender;
+    std::string botFaction;
+    std::string botGuild;
+    std::string botGroupStatus;
+    uint32_t botGold = 0;
+
+    std::string playerName;
+    uint32_t playerLevel = 0;
+    std::string playerClass;
+    std::string playerRace;
+    std::string playerRole;
+    std::string playerGender;
+    std::string playerFaction;
+    std::string playerGuild;
+    std::string playerGroupStatus;
+    uint32_t playerGold = 0;
+    float playerDistance = -1.0f;
+
+    std::string sentimentInfo;
+
+    bool hasGameState = false;
+    BotGameStateSnapshot gameState;
+};
+
+static BotPromptSnapshot CaptureBotPromptSnapshot(Player* bot, std::string playerMessage, Player* player);
+static OllamaRequest BuildBotPromptRequest(const BotPromptSnapshot& snapshot);
+
+// True if another player is within range of source, searching only the nearby grid cells.
+static bool IsAnyoneInRange(Player* source, float range)
+{
+    std::list<Player*> nearbyPlayers;
+    Acore::AnyPlayerInObjectRangeCheck check(source, range, false);
+    Acore::PlayerListSearcher<Acore::AnyPlayerInObjectRangeCheck> searcher(source, nearbyPlayers, check);
+    Cell::VisitWorldObjects(source, searcher, range);
+    for (Player* nearbyPlayer : nearbyPlayers)
     {
-        // look up the template
-        Quest const* quest = sObjectMgr->GetQuestTemplate(questId);
-        if (!quest)
-            continue;
+        if (nearbyPlayer != source)
+            return true;
+    }
+    return false;
+}
+
+// Send a bot reply to the chat it answers: the named channel when one is
+// given, otherwise the channel type in sourceLocal. Say and Yell are only
+// sent when someone is in range to hear them. Unless routing says otherwise,
+// other bots in that chat then get the chance to answer it in turn.
+void RouteBotReply(Player* botPtr, uint64_t senderGuid, ChatChannelSourceLocal sourceLocal, uint32_t channelId,
+                   const std::string& channelName, const std::string& response, BotReplyRouting routing)
+{
+    PlayerbotAI* botAI = PlayerbotsMgr::instance().GetPlayerbotAI(botPtr);
+    if (!botAI)
+    {
+        return;
+    }
 
-        // get the English title as a fallback
-        std::string title = quest->GetTitle();
+    bool send = routing != BOT_REPLY_NOTIFY_ONLY;
+    bool notifyBots = routing != BOT_REPLY_SEND_ONLY;
 
-        // then, if we have a locale record, overwrite it
-        if (auto const* locale = sObjectMgr->GetQuestLocale(questId))
+    if (channelId != 0 && !channelName.empty())
+    {
+        // For channels, get the channel instance for the bot's team
+        ChannelMgr* cMgr = ChannelMgr::forTeam(botPtr->GetTeamId());
+        if (cMgr)
         {
-            int locIdx = bot->GetSession()->GetSessionDbLocaleIndex();
-            if (locIdx >= 0)
-                ObjectMgr::GetLocaleString(locale->Title, locIdx, title);
+            Channel* targetChannel = cMgr->GetChannel(channelName, botPtr);
+            if (targetChannel)
+            {
+                if(g_DebugEnabled)
+                {
+                    LOG_INFO("server.loading", "[Ollama Chat] Bot {} found channel '{}' (ID: {}), checking membership...", 
+                            botPtr->GetName(), channelName, targetChannel->GetChannelId());
+                }
+                
+                if (botPtr->IsInChannel(targetChannel))
+                {
+                    if(g_DebugEnabled)
+                    {
+                        LOG_INFO("server.loading", "[Ollama Chat] Bot {} is confirmed in channel '{}', sending message...", 
+                                botPtr->GetName(), channelName);
+                    }
+                    if (send)
+                        targetChannel->Say(botPtr->GetGUID(), response, LANG_UNIVERSAL);
+                    if (notifyBots)
+                        ProcessBotChatMessage(botPtr, response, SRC_GENERAL_LOCAL, targetChannel);
+                    if(g_DebugEnabled)
+                    {
+                        LOG_INFO("server.loading", "[Ollama Chat] Bot {} responded in channel {}: {}", 
+                                botPtr->GetName(), channelName, response);
+                    }
+                }
+                else
+                {
+                    if(g_DebugEnabled)
+                    {
+                        LOG_ERROR("server.loading", "[Ollama Chat] Bot {} NOT in channel '{}' according to IsInChannel check - skipping reply", 
+                                    botPtr->GetName(), channelName);
+                    }
+                    // Don't fallback to Say - if bot isn't in the channel, don't reply at all
+                }
+            }
+            else
+            {
+                if(g_DebugEnabled)
+                {
+                    LOG_ERROR("server.loading", "[Ollama Chat] Bot {} cannot find channel '{}' (ID: {}) for team {} - skipping reply", 
+                             botPtr->GetName(), channelName, channelId, (int)botPtr->GetTeamId());
+                }
+                // Don't fallback to Say - if channel doesn't exist, don't reply at all
+            }
         }
+    }
+    else
+    {
+        switch (sourceLocal)
+        {
+            case SRC_GUILD_LOCAL: 
+                if (send)
+                    botAI->SayToGuild(response);
+                if (notifyBots)
+                    ProcessBotChatMessage(botPtr, response, SRC_GUILD_LOCAL, nullptr);
+                break;
+            case SRC_OFFICER_LOCAL: 
+                if (send)
+                    botAI->SayToGuild(response);
+                if (notifyBots)
+                    ProcessBotChatMessage(botPtr, response, SRC_OFFICER_LOCAL, nullptr);
+                break;
+            case SRC_PARTY_LOCAL: 
+                if (send)
+                    botAI->SayToParty(response);
+                if (notifyBots)
+                    ProcessBotChatMessage(botPtr, response, SRC_PARTY_LOCAL, nullptr);
+                break;
+            case SRC_RAID_LOCAL:  
+                if (send)
+                    botAI->SayToRaid(response);
+                if (notifyBots)
+                    ProcessBotChatMessage(botPtr, response, SRC_RAID_LOCAL, nullptr);
+                break;
+            case SRC_SAY_LOCAL:
+                // Only send Say if someone (real player or bot) is within say distance
+                {
+                    bool someoneCanHear = botPtr->IsInWorld() && IsAnyoneInRange(botPtr, g_SayDistance);
+                    
+                    if (someoneCanHear)
+                    {
+                        if (send)
+                            botAI->Say(response);
+                        if (notifyBots)
+                            ProcessBotChatMessage(botPtr, response, SRC_SAY_LOCAL, nullptr);
+                    }
+                    else if (g_DebugEnabled)
+                    {
+                        LOG_INFO("server.loading", "[Ollama Chat] Bot {} skipping Say reply - no one within {} yards to hear it", 
+                                botPtr->GetName(), g_SayDistance);
+                    }
+                }
+                break;
+            case SRC_YELL_LOCAL:
+                // Only send Yell if someone is within yell distance
+                {
+                    bool someoneCanHear = botPtr->IsInWorld() && IsAnyoneInRange(botPtr, g_YellDistance);
+                    
+                    if (someoneCanHear)
+                    {
+                        if (send)
+                            botAI->Yell(response);
+                        if (notifyBots)
+                            ProcessBotChatMessage(botPtr, response, SRC_YELL_LOCAL, nullptr);
+                    }
+                    else if (g_DebugEnabled)
+                    {
+                        LOG_INFO("server.loading", "[Ollama Chat] Bot {} skipping Yell reply - no one within {} yards to hear it", 
+                                botPtr->GetName(), g_YellDistance);
+                    }
+                }
+                break;
+            case SRC_WHISPER_LOCAL:
+                // For whispers, find the original sender and whisper back
+                {
+                    Player* originalSender = ObjectAccessor::FindPlayer(ObjectGuid(senderGuid));
+                    if (originalSender)
+                    {
+                        if(g_DebugEnabled)
+                        {
+                            LOG_INFO("server.loading", "[Ollama Chat] Bot {} whispering response '{}' to {}", 
+                                    botPtr->GetName(), response, originalSender->GetName());
+                        }
+                        if (send)
+                            botAI->Whisper(response, originalSender->GetName());
+                        // Don't trigger ProcessBotChatMessage for whispers - they're private
+                    }
+                    else if(g_DebugEnabled)
+                    {
+                        LOG_ERROR("server.loading", "[Ollama Chat] Cannot whisper response - original sender not found for GUID {}", senderGuid);
+                    }
+                }
+                break;
+            default:              
+                if (send)
+                    botAI->Say(response);
+                if (notifyBots)
+                    ProcessBotChatMessage(botPtr, response, SRC_SAY_LOCAL, nullptr);
+                break;
+        }
+    }
+}
 
-        // Convert quest status to readable string
-        std::string statusText;
-        switch (qsd.Status)
+// Outbox handler for one streamed sentence of a reply. Other bots only hear
+// the whole reply, from DeliverChatReply, so a reply streamed as several
+// sentences starts one round of bot replies rather than one per sentence.
+static void DeliverChatSentence(Player* bot, const OllamaReply& reply)
+{
+    RouteBotReply(bot, reply.senderGuid, reply.sourceLocal, reply.channelId, reply.channelName, reply.text,
+                  BOT_REPLY_SEND_ONLY);
+}
+
+// Outbox handler for a finished reply: sends it unless it was streamed, lets
+// other bots answer the full text, then records it in the conversation
+// history.
+static void DeliverChatReply(Player* bot, const OllamaReply& reply)
+{
+    Player* sender = ObjectAccessor::FindPlayer(ObjectGuid(reply.senderGuid));
+    if (!sender)
+    {
+        if(g_DebugEnabled)
         {
-            case QUEST_STATUS_NONE:       statusText = "not started"; break;
-            case QUEST_STATUS_COMPLETE:   statusText = "complete (ready to turn in)"; break;
-            case QUEST_STATUS_INCOMPLETE: statusText = "in progress"; break;
-            case QUEST_STATUS_FAILED:     statusText = "failed"; break;
-            case QUEST_STATUS_REWARDED:   statusText = "completed and rewarded"; break;
-            default:                      statusText = "unknown"; break;
+            LOG_ERROR("server.loading", "[Ollama Chat] Failed to reacquire sender from GUID {}", reply.senderGuid);
         }
-
-        quests += "Quest \"" + title + "\" is " + statusText + "\n";
+        return;
     }
 
-    std::string los;
-    std::vector<std::string> losLocs = ChatHandler_GetVisibleLocations(bot);
-    if (!losLocs.empty()) {
-        for (const auto& entry : losLocs) los += " - " + entry + "\n";
-    }
+    RouteBotReply(bot, reply.senderGuid, reply.sourceLocal, reply.channelId, reply.channelName, reply.text,
+                  reply.sent ? BOT_REPLY_NOTIFY_ONLY : BOT_REPLY_SEND_AND_NOTIFY);
 
-    std::string players;
-    std::vector<std::string> nearbyPlayers = ChatHandler_GetVisiblePlayers(bot);
-    if (!nearbyPlayers.empty()) {
-        for (const auto& entry : nearbyPlayers) players += " - " + entry + "\n";
+    AppendBotConversation(reply.botGuid, reply.senderGuid, reply.playerMessage, reply.text);
+    if(g_DebugEnabled)
+    {
+        if (bot->IsInWorld() && sender->IsInWorld())
+        {
+            LOG_INFO("server.loading", "[Ollama Chat] Bot {} (distance: {}) responded: {}", bot->GetName(), sender->GetDistance(bot), reply.text);
+        }
+        else
+        {
+            LOG_INFO("server.loading", "[Ollama Chat] Bot {} responded: {} (distance not calculated - players not in world)", bot->GetName(), reply.text);
+        }
     }
-
-    // Use template
-    return SafeFormat(
-        g_ChatBotSnapshotTemplate,
-        fmt::arg("combat", combat),
-        fmt::arg("group", group),
-        fmt::arg("spells", spells),
-        fmt::arg("quests", quests),
-        fmt::arg("los", los),
-        fmt::arg("players", players)
-    );
 }
 
-
 void PlayerBotChatHandler::ProcessChat(Player* player, uint32_t /*type*/, uint32_t lang, std::string& msg, ChatChannelSourceLocal sourceLocal, Channel* channel, Player* receiver)
 {
     if (player == nullptr) {
@@ -892,8 +1495,7 @@ void PlayerBotChatHandler::ProcessChat(Player* player, uint32_t /*type*/, uint32
         return;
     }
              
-    PlayerbotAI* senderAI = PlayerbotsMgr::instance().GetPlayerbotAI(player);
-    bool senderIsBot = (senderAI && senderAI->IsBotAI());
+    bool senderIsBot = IsBotPlayer(player);
     
     std::vector<Player*> eligibleBots;
     
@@ -923,8 +1525,7 @@ void PlayerBotChatHandler::ProcessChat(Player* player, uint32_t /*type*/, uint32
         }
         
         // For whispers, only the receiver bot can respond (if it's a bot)
-        PlayerbotAI* receiverAI = PlayerbotsMgr::instance().GetPlayerbotAI(receiver);
-        if (receiverAI && receiverAI->IsBotAI())
+        if (IsBotPlayer(receiver))
         {
             eligibleBots.push_back(receiver);
             if(g_DebugEnabled)
@@ -956,25 +1557,42 @@ void PlayerBotChatHandler::ProcessChat(Player* player, uint32_t /*type*/, uint32
             return;
         }
         
-        // For channel chat, simply find all bots in the same zone as the player
-        auto const& allPlayers = ObjectAccessor::GetPlayers();
-        for (auto const& itr : allPlayers)
+        // Check if this is a local or global channel
+        bool isLocalChannel = (channel->GetName().find("General -") != std::string::npos || 
+                              channel->GetName().find("Trade -") != std::string::npos ||
+                              channel->GetName().find("LocalDefense -") != std::string::npos);
+        
+        bool isGlobalChannel = (channel->GetName().find("World") != std::string::npos || channel->GetName().find("LookingForGroup") != std::string::npos);
+
+        // REAL PLAYER CHECK: Channel must have at least one real player. Zone channels
+        // only have members from their zone, so only that zone's real players are checked.
+        bool hasRealPlayerInChannel = false;
+        for (Player* potentialRealPlayer : isLocalChannel ? g_PresenceIndex.GetRealPlayersInZone(player->GetZoneId())
+                                                          : g_PresenceIndex.GetRealPlayers())
         {
-            Player* candidate = itr.second;
-            if (!candidate || candidate == player)
-                continue;
-                
-            // Skip non-bots early
-            PlayerbotAI* candidateAI = PlayerbotsMgr::instance().GetPlayerbotAI(candidate);
-            if (!candidateAI || !candidateAI->IsBotAI())
+            if (potentialRealPlayer->IsInChannel(channel))
+            {
+                hasRealPlayerInChannel = true;
+                break;
+            }
+        }
+
+        // For local channels only bots in the player's zone can be members
+        std::vector<Player*> channelCandidates;
+        if (hasRealPlayerInChannel)
+        {
+            channelCandidates = isLocalChannel ? g_PresenceIndex.GetBotsInZone(player->GetZoneId())
+                                               : g_PresenceIndex.GetBots();
+        }
+        else if(g_DebugEnabled)
+        {
+            LOG_INFO("server.loading", "[Ollama Chat] No real players in channel '{}', skipping", channel->GetName());
+        }
+
+        for (Player* candidate : channelCandidates)
+        {
+            if (candidate == player)
                 continue;
-            
-            // Check if this is a local or global channel
-            bool isLocalChannel = (channel->GetName().find("General -") != std::string::npos || 
-                                  channel->GetName().find("Trade -") != std::string::npos ||
-                                  channel->GetName().find("LocalDefense -") != std::string::npos);
-            
-            bool isGlobalChannel = (channel->GetName().find("World") != std::string::npos || channel->GetName().find("LookingForGroup") != std::string::npos);
         
             // For local channels, bot must be in same zone as player
             if (isLocalChannel)
@@ -1024,31 +1642,6 @@ void PlayerBotChatHandler::ProcessChat(Player* player, uint32_t /*type*/, uint32
                 continue; // SKIP this bot - not in the channel
             }
             
-            // REAL PLAYER CHECK: Channel must have at least one real player
-            bool hasRealPlayerInChannel = false;
-            for (auto const& playerItr : allPlayers)
-            {
-                Player* potentialRealPlayer = playerItr.second;
-                if (potentialRealPlayer && potentialRealPlayer->IsInChannel(channel))
-                {
-                    PlayerbotAI* realPlayerAI = PlayerbotsMgr::instance().GetPlayerbotAI(potentialRealPlayer);
-                    if (!realPlayerAI || !realPlayerAI->IsBotAI())
-                    {
-                        hasRealPlayerInChannel = true;
-                        break;
-                    }
-                }
-            }
-            
-            if (!hasRealPlayerInChannel)
-            {
-                if(g_DebugEnabled)
-                {
-                    //LOG_INFO("server.loading", "[Ollama Chat] Bot {} skipped - no real players in channel '{}'", candidate->GetName(), channel->GetName());
-                }
-                continue;
-            }
-            
             // ONLY add bots that passed ALL verifications
             eligibleBots.push_back(candidate);
             if(g_DebugEnabled)
@@ -1065,96 +1658,108 @@ void PlayerBotChatHandler::ProcessChat(Player* player, uint32_t /*type*/, uint32
     }
     else
     {
-        // For other chat types (say, yell, guild, party, etc.), use all players and filter by eligibility
-        auto const& allPlayers = ObjectAccessor::GetPlayers();
-        for (auto const& itr : allPlayers)
+        // For other chat types (say, yell, guild, party), collect only the bots that can hear
+        // the message and filter by eligibility.
+        bool isGuildSource = (sourceLocal == SRC_GUILD_LOCAL || sourceLocal == SRC_OFFICER_LOCAL);
+        std::vector<Player*> scopeCandidates;
+        std::vector<Player*> realPlayers; // real players near the sender, for Say/Yell
+        if (isGuildSource)
+        {
+            // A guild with no real player online gets no replies
+            if (g_PresenceIndex.HasRealPlayerInGuild(player->GetGuildId()))
+                scopeCandidates = g_PresenceIndex.GetBotsInGuild(player->GetGuildId());
+        }
+        else if (sourceLocal == SRC_PARTY_LOCAL || sourceLocal == SRC_RAID_LOCAL)
+        {
+            // Only bots in the sender's group can hear party/raid chat
+            if (Group* group = player->GetGroup())
+            {
+                for (GroupReference* ref = group->GetFirstMember(); ref; ref = ref->next())
+                {
+                    Player* member = ref->GetSource();
+                    if (!member)
+                        continue;
+                    if (IsBotPlayer(member))
+                        scopeCandidates.push_back(member);
+                }
+            }
+        }
+        else if (sourceLocal == SRC_SAY_LOCAL || sourceLocal == SRC_YELL_LOCAL)
+        {
+            // Search the sender's surrounding grid cells instead of every online player. Bots must be
+            // within hearing range of the sender; a real player who can hear a replying bot is at most
+            // twice that far away, so one search at double range finds both.
+            float threshold = (sourceLocal == SRC_SAY_LOCAL) ? g_SayDistance : g_YellDistance;
+            if (threshold > 0.0f && player->IsInWorld())
+            {
+                std::list<Player*> nearbyPlayers;
+                Acore::AnyPlayerInObjectRangeCheck nearbyCheck(player, threshold * 2.0f, false);
+                Acore::PlayerListSearcher<Acore::AnyPlayerInObjectRangeCheck> nearbySearcher(player, nearbyPlayers, nearbyCheck);
+                Cell::VisitWorldObjects(player, nearbySearcher, threshold * 2.0f);
+                for (Player* nearbyPlayer : nearbyPlayers)
+                {
+                    if (!IsBotPlayer(nearbyPlayer))
+                        realPlayers.push_back(nearbyPlayer);
+                    else if (player->GetDistance(nearbyPlayer) <= threshold)
+                        scopeCandidates.push_back(nearbyPlayer);
+                }
+            }
+        }
+        else
+        {
+            scopeCandidates = g_PresenceIndex.GetBots();
+        }
+
+        for (Player* candidate : scopeCandidates)
         {
-            Player* candidate = itr.second;
             if (candidate->IsInWorld() && candidate != player)
             {
-                PlayerbotAI* candidateAI = PlayerbotsMgr::instance().GetPlayerbotAI(candidate);
-                if (candidateAI && candidateAI->IsBotAI())
+                if (sourceLocal == SRC_PARTY_LOCAL || sourceLocal == SRC_RAID_LOCAL)
                 {
-                    // For Guild/Party, verify there's a real player in that guild/party
-                    if (sourceLocal == SRC_GUILD_LOCAL || sourceLocal == SRC_OFFICER_LOCAL)
-                    {
-                        if (candidate->GetGuildId() != 0)
-                        {
-                            // Check if any real player is online in this guild
-                            bool hasRealPlayerInGuild = false;
-                            for (auto const& guildPlayerItr : allPlayers)
-                            {
-                                Player* guildMember = guildPlayerItr.second;
-                                if (guildMember && guildMember->GetGuildId() == candidate->GetGuildId())
-                                {
-                                    PlayerbotAI* memberAI = PlayerbotsMgr::instance().GetPlayerbotAI(guildMember);
-                                    if (!memberAI || !memberAI->IsBotAI())
-                                    {
-                                        hasRealPlayerInGuild = true;
-                                        break;
-                                    }
-                                }
-                            }
-                            if (!hasRealPlayerInGuild)
-                                continue; // Skip bot - no real players in guild
-                        }
-                    }
-                    else if (sourceLocal == SRC_PARTY_LOCAL || sourceLocal == SRC_RAID_LOCAL)
+                    Group* group = candidate->GetGroup();
+                    if (group)
                     {
-                        Group* group = candidate->GetGroup();
-                        if (group)
+                        // Check if any real player is in this group
+                        bool hasRealPlayerInGroup = false;
+                        for (GroupReference* ref = group->GetFirstMember(); ref; ref = ref->next())
                         {
-                            // Check if any real player is in this group
-                            bool hasRealPlayerInGroup = false;
-                            for (GroupReference* ref = group->GetFirstMember(); ref; ref = ref->next())
+                            Player* member = ref->GetSource();
+                            if (member)
                             {
-                                Player* member = ref->GetSource();
-                                if (member)
+                                if (!IsBotPlayer(member))
                                 {
-                                    PlayerbotAI* memberAI = PlayerbotsMgr::instance().GetPlayerbotAI(member);
-                                    if (!memberAI || !memberAI->IsBotAI())
-                                    {
-                                        hasRealPlayerInGroup = true;
-                                        break;
-                                    }
+                                    hasRealPlayerInGroup = true;
+                                    break;
                                 }
                             }
-                            if (!hasRealPlayerInGroup)
-                                continue; // Skip bot - no real players in group
                         }
+                        if (!hasRealPlayerInGroup)
+                            continue; // Skip bot - no real players in group
                     }
-                    else if (sourceLocal == SRC_SAY_LOCAL || sourceLocal == SRC_YELL_LOCAL)
+                }
+                else if (sourceLocal == SRC_SAY_LOCAL || sourceLocal == SRC_YELL_LOCAL)
+                {
+                    // For Say/Yell, require a real player within hearing distance
+                    float threshold = (sourceLocal == SRC_SAY_LOCAL) ? g_SayDistance : g_YellDistance;
+                    bool hasRealPlayerNearby = false;
+                    
+                    if (candidate->IsInWorld() && threshold > 0.0f)
                     {
-                        // For Say/Yell, require a real player within hearing distance
-                        float threshold = (sourceLocal == SRC_SAY_LOCAL) ? g_SayDistance : g_YellDistance;
-                        bool hasRealPlayerNearby = false;
-                        
-                        if (candidate->IsInWorld() && threshold > 0.0f)
+                        for (Player* nearbyPlayer : realPlayers)
                         {
-                            for (auto const& nearbyPlayerItr : allPlayers)
+                            if (nearbyPlayer->IsInWorld() && candidate->GetDistance(nearbyPlayer) <= threshold)
                             {
-                                Player* nearbyPlayer = nearbyPlayerItr.second;
-                                if (nearbyPlayer && nearbyPlayer->IsInWorld())
-                                {
-                                    PlayerbotAI* nearbyAI = PlayerbotsMgr::instance().GetPlayerbotAI(nearbyPlayer);
-                                    if (!nearbyAI || !nearbyAI->IsBotAI())
-                                    {
-                                        if (candidate->GetDistance(nearbyPlayer) <= threshold)
-                                        {
-                                            hasRealPlayerNearby = true;
-                                            break;
-                                        }
-                                    }
-                                }
+                                hasRealPlayerNearby = true;
+                                break;
                             }
                         }
-                        
-                        if (!hasRealPlayerNearby)
-                            continue; // Skip bot - no real player can hear Say/Yell
                     }
                     
-                    eligibleBots.push_back(candidate);
+                    if (!hasRealPlayerNearby)
+                        continue; // Skip bot - no real player can hear Say/Yell
                 }
+                
+                eligibleBots.push_back(candidate);
             }
         }
     }
@@ -1231,6 +1836,7 @@ void PlayerBotChatHandler::ProcessChat(Player* player, uint32_t /*type*/, uint32
     }
     
     std::vector<Player*> finalCandidates;
+    bool botWasMentioned = false;
     
     // For whispers, handle directly - there should only be one receiver bot
     if (sourceLocal == SRC_WHISPER_LOCAL)
@@ -1253,39 +1859,9 @@ void PlayerBotChatHandler::ProcessChat(Player* player, uint32_t /*type*/, uint32
         // Handle non-whisper chats with normal multi-bot logic
         std::vector<std::pair<size_t, Player*>> mentionedBots;
 
-        // Helper to convert string to lowercase safely
-        auto toLowerStr = [](const std::string& str) -> std::string {
-            std::string result = str;
-            for (char& c : result)
-            {
-                c = std::tolower(static_cast<unsigned char>(c));
-            }
-            return result;
-        };
-
-        // Helper to check if a bot name is mentioned as a complete word
-        auto isBotNameMentioned = [&trimmedMsg, &toLowerStr](const std::string& botName) -> size_t {
-            std::string lowerMsg = toLowerStr(trimmedMsg);
-            std::string lowerBotName = toLowerStr(botName);
-            
-            size_t pos = 0;
-            while ((pos = lowerMsg.find(lowerBotName, pos)) != std::string::npos)
-            {
-                // Check if it's a word boundary before the name
-                bool validStart = (pos == 0 || !std::isalnum(static_cast<unsigned char>(lowerMsg[pos - 1])));
-                // Check if it's a word boundary after the name
-                size_t endPos = pos + lowerBotName.length();
-                bool validEnd = (endPos >= lowerMsg.length() || !std::isalnum(static_cast<unsigned char>(lowerMsg[endPos])));
-                
-                if (validStart && validEnd)
-                {
-                    return pos; // Found a valid word-boundary match
-                }
-                pos++; // Continue searching
-            }
-            return std::string::npos;
-        };
-
+        // Match every candidate's name against the message in a single pass
+        std::vector<Player*> mentionableBots;
+        MentionMatcher mentionMatcher;
         for (Player* bot : candidateBots)
         {
             if (!bot)
@@ -1296,15 +1872,26 @@ void PlayerBotChatHandler::ProcessChat(Player* player, uint32_t /*type*/, uint32
             {
                 continue;
             }
-            
-            size_t pos = isBotNameMentioned(bot->GetName());
-            if (pos != std::string::npos)
+            mentionMatcher.Add(bot->GetName(), mentionableBots.size());
+            mentionableBots.push_back(bot);
+        }
+        mentionMatcher.Build();
+
+        std::vector<bool> alreadyMentioned(mentionableBots.size(), false);
+        for (const auto& [pos, index] : mentionMatcher.FindAll(trimmedMsg))
+        {
+            // Only the first mention of each bot counts
+            if (alreadyMentioned[index])
             {
-                mentionedBots.emplace_back(pos, bot);
-                if(g_DebugEnabled)
-                {
-                    LOG_INFO("server.loading", "[Ollama Chat] Bot {} mentioned at position {} in message", bot->GetName(), pos);
-                }
+                continue;
+            }
+            alreadyMentioned[index] = true;
+
+            Player* bot = mentionableBots[index];
+            mentionedBots.emplace_back(pos, bot);
+            if(g_DebugEnabled)
+            {
+                LOG_INFO("server.loading", "[Ollama Chat] Bot {} mentioned at position {} in message", bot->GetName(), pos);
             }
         }
 
@@ -1317,6 +1904,7 @@ void PlayerBotChatHandler::ProcessChat(Player* player, uint32_t /*type*/, uint32
             if (!(g_DisableRepliesInCombat && chosen->IsInCombat()))
             {
                 finalCandidates.push_back(chosen);
+                botWasMentioned = true;
                 if(g_DebugEnabled)
                 {
                     LOG_INFO("server.loading", "[Ollama Chat] Bot {} selected (mentioned first at position {})", 
@@ -1397,6 +1985,22 @@ void PlayerBotChatHandler::ProcessChat(Player* player, uint32_t /*type*/, uint32
     }
     
     uint64_t senderGuid = player->GetGUID().GetRawValue();
+
+    // Guild chat uses the guild model profile, everything else the conversation profile.
+    QueryPurpose purpose = (sourceLocal == SRC_GUILD_LOCAL || sourceLocal == SRC_OFFICER_LOCAL)
+        ? QueryPurpose::Guild : QueryPurpose::Conversation;
+
+    // Human-initiated conversation is served before bot-to-bot chatter.
+    QueryPriority priority = QueryPriority::Ambient;
+    if (!senderIsBot)
+    {
+        if (sourceLocal == SRC_WHISPER_LOCAL)
+            priority = QueryPriority::Whisper;
+        else if (botWasMentioned)
+            priority = QueryPriority::Mention;
+        else
+            priority = QueryPriority::PartyGuild;
+    }
     
     for (Player* bot : finalCandidates)
     {
@@ -1408,266 +2012,83 @@ void PlayerBotChatHandler::ProcessChat(Player* player, uint32_t /*type*/, uint32
         if (bot == nullptr) {
             continue;
         }
-        std::string prompt = GenerateBotPrompt(bot, msg, player);
-        uint64_t botGuid = bot->GetGUID().GetRawValue();
-        
-        std::thread([botGuid, senderGuid, prompt, sourceLocal, channelId = (channel ? channel->GetChannelId() : 0), channelName = (channel ? channel->GetName() : ""), msg]() {
-            try {
-                // Use the QueryManager to submit the query.
-                auto responseFuture = SubmitQuery(prompt);
-                if (!responseFuture.valid())
-                {
-                    return;
-                }
-                std::string response = responseFuture.get();
+        // Read the game state here on the world thread; the prompt itself is
+        // formatted on the query worker from this copy.
+        auto snapshot = std::make_shared<BotPromptSnapshot>(CaptureBotPromptSnapshot(bot, msg, player));
+        if (!snapshot->valid) {
+            continue;
+        }
 
-                // Reacquire pointers by GUID.
-                Player* botPtr = ObjectAccessor::FindPlayer(ObjectGuid(botGuid));
-                Player* senderPtr = ObjectAccessor::FindPlayer(ObjectGuid(senderGuid));
-                if (!botPtr)
-                {
-                    if(g_DebugEnabled)
-                    {
-                        LOG_ERROR("server.loading", "[Ollama Chat] Failed to reacquire bot from GUID {}", botGuid);
-                    }
-                    return;
-                }
-                if (!senderPtr)
+        OllamaReply reply;
+        reply.botGuid = bot->GetGUID().GetRawValue();
+        reply.senderGuid = senderGuid;
+        reply.sourceLocal = sourceLocal;
+        reply.channelId = channel ? channel->GetChannelId() : 0;
+        reply.channelName = channel ? channel->GetName() : "";
+
+        // Each sentence goes to chat as soon as it is generated.
+        bool streamed = g_EnableStreaming;
+        QuerySentenceFn onSentence;
+        if (streamed)
+        {
+            onSentence = [reply](const std::string& sentence) {
+                if (!g_PresenceIndex.IsOnline(reply.botGuid))
                 {
-                    if(g_DebugEnabled)
-                    {
-                        LOG_ERROR("server.loading", "[Ollama Chat] Failed to reacquire sender from GUID {}", senderGuid);
-                    }
-                    return;
+                    return false;
                 }
+                OllamaReply part = reply;
+                part.deliver = DeliverChatSentence;
+                part.text = sentence;
+                g_ReplyOutbox.Push(std::move(part));
+                return true;
+            };
+        }
+
+        // Everything below runs on the query worker, so no thread is parked
+        // waiting for the LLM.
+        SubmitQueryAsync(OllamaRequest(), priority,
+            [snapshot, reply, streamed, msg](std::string response) mutable {
                 if (response.empty())
                 {
                     if(g_DebugEnabled)
                     {
-                        LOG_INFO("server.loading", "[OllamaChat] Bot {} skipped reply due to API error", botPtr->GetName());
-                    }
-                    return;
-                }
-                PlayerbotAI* botAI = PlayerbotsMgr::instance().GetPlayerbotAI(botPtr);
-                if (!botAI)
-                {
-                    if(g_DebugEnabled)
-                    {
-                        LOG_ERROR("server.loading", "[Ollama Chat] No PlayerbotAI found for bot {}", botPtr->GetName());
+                        LOG_INFO("server.loading", "[OllamaChat] Bot {} skipped reply due to API error", snapshot->botName);
                     }
                     return;
                 }
                 
-                // Simulate typing delay if enabled
-                if (g_EnableTypingSimulation)
+                // Simulate typing delay if enabled (streamed replies are already paced by generation).
+                // The outbox holds the reply until then; no thread waits for it.
+                if (g_EnableTypingSimulation && !streamed)
                 {
-                    uint32_t delay = g_TypingSimulationBaseDelay + (response.length() * g_TypingSimulationDelayPerChar);
+                    auto delay = GetTypingDelay(response.length());
                     if (g_DebugEnabled)
                         LOG_INFO("server.loading", "[OllamaChat] Bot {} simulating typing delay: {}ms for {} characters", 
-                                 botPtr->GetName(), delay, response.length());
-                    std::this_thread::sleep_for(std::chrono::milliseconds(delay));
-                    
-                    // Reacquire pointers after delay
-                    botPtr = ObjectAccessor::FindPlayer(ObjectGuid(botGuid));
-                    if (!botPtr) return;
-                    botAI = PlayerbotsMgr::instance().GetPlayerbotAI(botPtr);
-                    if (!botAI) return;
-                    senderPtr = ObjectAccessor::FindPlayer(ObjectGuid(senderGuid));
-                    if (!senderPtr) return;
-                }
-                
-                // Route the response.
-                if (channelId != 0 && !channelName.empty())
-                {
-                    // For channels, get the channel instance for the bot's team
-                    ChannelMgr* cMgr = ChannelMgr::forTeam(botPtr->GetTeamId());
-                    if (cMgr)
-                    {
-                        Channel* targetChannel = cMgr->GetChannel(channelName, botPtr);
-                        if (targetChannel)
-                        {
-                            if(g_DebugEnabled)
-                            {
-                                LOG_INFO("server.loading", "[Ollama Chat] Bot {} found channel '{}' (ID: {}), checking membership...", 
-                                        botPtr->GetName(), channelName, targetChannel->GetChannelId());
-                            }
-                            
-                            if (botPtr->IsInChannel(targetChannel))
-                            {
-                                if(g_DebugEnabled)
-                                {
-                                    LOG_INFO("server.loading", "[Ollama Chat] Bot {} is confirmed in channel '{}', sending message...", 
-                                            botPtr->GetName(), channelName);
-                                }
-                                targetChannel->Say(botPtr->GetGUID(), response, LANG_UNIVERSAL);
-                                ProcessBotChatMessage(botPtr, response, SRC_GENERAL_LOCAL, targetChannel);
-                                if(g_DebugEnabled)
-                                {
-                                    LOG_INFO("server.loading", "[Ollama Chat] Bot {} responded in channel {}: {}", 
-                                            botPtr->GetName(), channelName, response);
-                                }
-                            }
-                            else
-                            {
-                                if(g_DebugEnabled)
-                                {
-                                    LOG_ERROR("server.loading", "[Ollama Chat] Bot {} NOT in channel '{}' according to IsInChannel check - skipping reply", 
-                                                botPtr->GetName(), channelName);
-                                }
-                                // Don't fallback to Say - if bot isn't in the channel, don't reply at all
-                            }
-                        }
-                        else
-                        {
-                            if(g_DebugEnabled)
-                            {
-                                LOG_ERROR("server.loading", "[Ollama Chat] Bot {} cannot find channel '{}' (ID: {}) for team {} - skipping reply", 
-                                         botPtr->GetName(), channelName, channelId, (int)botPtr->GetTeamId());
-                            }
-                            // Don't fallback to Say - if channel doesn't exist, don't reply at all
-                        }
-                    }
-                }
-                else
-                {
-                    switch (sourceLocal)
-                    {
-                        case SRC_GUILD_LOCAL: 
-                            botAI->SayToGuild(response);
-                            ProcessBotChatMessage(botPtr, response, SRC_GUILD_LOCAL, nullptr);
-                            break;
-                        case SRC_OFFICER_LOCAL: 
-                            botAI->SayToGuild(response);
-                            ProcessBotChatMessage(botPtr, response, SRC_OFFICER_LOCAL, nullptr);
-                            break;
-                        case SRC_PARTY_LOCAL: 
-                            botAI->SayToParty(response);
-                            ProcessBotChatMessage(botPtr, response, SRC_PARTY_LOCAL, nullptr);
-                            break;
-                        case SRC_RAID_LOCAL:  
-                            botAI->SayToRaid(response);
-                            ProcessBotChatMessage(botPtr, response, SRC_RAID_LOCAL, nullptr);
-                            break;
-                        case SRC_SAY_LOCAL:
-                            // Only send Say if someone (real player or bot) is within say distance
-                            {
-                                bool someoneCanHear = false;
-                                if (botPtr->IsInWorld())
-                                {
-                                    for (auto const& pair : ObjectAccessor::GetPlayers())
-                                    {
-                                        Player* nearbyPlayer = pair.second;
-                                        if (nearbyPlayer && nearbyPlayer != botPtr && nearbyPlayer->IsInWorld())
-                                        {
-                                            if (botPtr->GetDistance(nearbyPlayer) <= g_SayDistance)
-                                            {
-                                                someoneCanHear = true;
-                                                break;
-                                            }
-                                        }
-                                    }
-                                }
-                                
-                                if (someoneCanHear)
-                                {
-                                    botAI->Say(response);
-                                    ProcessBotChatMessage(botPtr, response, SRC_SAY_LOCAL, nullptr);
-                                }
-                                else if (g_DebugEnabled)
-                                {
-                                    LOG_INFO("server.loading", "[Ollama Chat] Bot {} skipping Say reply - no one within {} yards to hear it", 
-                                            botPtr->GetName(), g_SayDistance);
-                                }
-                            }
-                            break;
-                        case SRC_YELL_LOCAL:
-                            // Only send Yell if someone is within yell distance
-                            {
-                                bool someoneCanHear = false;
-                                if (botPtr->IsInWorld())
-                                {
-                                    for (auto const& pair : ObjectAccessor::GetPlayers())
-                                    {
-                                        Player* nearbyPlayer = pair.second;
-                                        if (nearbyPlayer && nearbyPlayer != botPtr && nearbyPlayer->IsInWorld())
-                                        {
-                                            if (botPtr->GetDistance(nearbyPlayer) <= g_YellDistance)
-                                            {
-                                                someoneCanHear = true;
-                                                break;
-                                            }
-                                        }
-                                    }
-                                }
-                                
-                                if (someoneCanHear)
-                                {
-                                    botAI->Yell(response);
-                                    ProcessBotChatMessage(botPtr, response, SRC_YELL_LOCAL, nullptr);
-                                }
-                                else if (g_DebugEnabled)
-                                {
-                                    LOG_INFO("server.loading", "[Ollama Chat] Bot {} skipping Yell reply - no one within {} yards to hear it", 
-                                            botPtr->GetName(), g_YellDistance);
-                                }
-                            }
-                            break;
-                        case SRC_WHISPER_LOCAL:
-                            // For whispers, find the original sender and whisper back
-                            {
-                                Player* originalSender = ObjectAccessor::FindPlayer(ObjectGuid(senderGuid));
-                                if (originalSender)
-                                {
-                                    if(g_DebugEnabled)
-                                    {
-                                        LOG_INFO("server.loading", "[Ollama Chat] Bot {} whispering response '{}' to {}", 
-                                                botPtr->GetName(), response, originalSender->GetName());
-                                    }
-                                    botAI->Whisper(response, originalSender->GetName());
-                                    // Don't trigger ProcessBotChatMessage for whispers - they're private
-                                }
-                                else if(g_DebugEnabled)
-                                {
-                                    LOG_ERROR("server.loading", "[Ollama Chat] Cannot whisper response - original sender not found for GUID {}", senderGuid);
-                                }
-                            }
-                            break;
-                        default:              
-                            botAI->Say(response);
-                            ProcessBotChatMessage(botPtr, response, SRC_SAY_LOCAL, nullptr);
-                            break;
-                    }
-                }
-                
-                // Update sentiment based on the player's message
-                UpdateBotPlayerSentiment(botPtr, senderPtr, msg);
-                
-                AppendBotConversation(botGuid, senderGuid, msg, response);
-                if (botPtr->IsInWorld() && senderPtr->IsInWorld())
-                {
-                    float respDistance = senderPtr->GetDistance(botPtr);
-                    if(g_DebugEnabled)
-                    {
-                        LOG_INFO("server.loading", "[Ollama Chat] Bot {} (distance: {}) responded: {}", botPtr->GetName(), respDistance, response);
-                    }
-                }
-                else
-                {
-                    if(g_DebugEnabled)
-                    {
-                        LOG_INFO("server.loading", "[Ollama Chat] Bot {} responded: {} (distance not calculated - players not in world)", botPtr->GetName(), response);
-                    }
-                }
-            }
-            catch (const std::exception& ex)
-            {
-                if(g_DebugEnabled)
-                {
-                    LOG_ERROR("server.loading", "[Ollama Chat] Exception in bot response thread: {}", ex.what());
+                                 snapshot->botName, delay.count(), response.length());
+                    reply.notBefore = std::chrono::steady_clock::now() + delay;
                 }
-            }
-        }).detach();
 
+                uint64_t botGuid = reply.botGuid;
+                uint64_t senderGuid = reply.senderGuid;
+
+                // Sending touches the players, so it happens when the world
+                // thread drains the outbox.
+                reply.deliver = DeliverChatReply;
+                reply.text = std::move(response);
+                reply.playerMessage = msg;
+                reply.sent = streamed;
+                g_ReplyOutbox.Push(std::move(reply));
+
+                // Update sentiment based on the player's message as a
+                // follow-up background query.
+                UpdateBotPlayerSentiment(botGuid, senderGuid, msg);
+            },
+            std::move(onSentence),
+            [snapshot, purpose](OllamaRequest& request) {
+                request = BuildBotPromptRequest(*snapshot);
+                request.purpose = purpose;
+                return !request.prompt.empty();
+            });
     }
 }
 
@@ -1680,7 +2101,7 @@ static bool IsBotEligibleForChatChannelLocal(Player* bot, Player* player, ChatCh
                     (void*)bot, (void*)player, (bot == player));
         return false;
     }
-    if (!PlayerbotsMgr::instance().GetPlayerbotAI(bot))
+    if (!HasPlayerbotAI(bot))
     {
         if (g_DebugEnabled)
             LOG_INFO("server.loading", "[Ollama Chat] IsBotEligible: Bot {} FAILED - no PlayerbotAI", bot->GetName());
@@ -1691,8 +2112,7 @@ static bool IsBotEligibleForChatChannelLocal(Player* bot, Player* player, ChatCh
     if (source == SRC_WHISPER_LOCAL)
     {
         // Don't allow bot-to-bot whisper responses
-        PlayerbotAI* senderAI = PlayerbotsMgr::instance().GetPlayerbotAI(player);
-        if (senderAI && senderAI->IsBotAI())
+        if (IsBotPlayer(player))
         {
             return false;
         }
@@ -1797,132 +2217,185 @@ static bool IsBotEligibleForChatChannelLocal(Player* bot, Player* player, ChatCh
     }
 }
 
-std::string GenerateBotPrompt(Player* bot, std::string playerMessage, Player* player)
-{  
+BotPromptSnapshot CaptureBotPromptSnapshot(Player* bot, std::string playerMessage, Player* player)
+{
+    BotPromptSnapshot snapshot;
     if (!bot || !player) {
-        return "";
+        return snapshot;
     }
     PlayerbotAI* botAI = PlayerbotsMgr::instance().GetPlayerbotAI(bot);
     if (botAI == nullptr) {
-        return "";
+        return snapshot;
     }
     ChatHelper* helper = botAI->GetChatHelper();
     if (helper == nullptr) {
-        return "";
-    }
-    if (g_ChatPromptTemplate.empty()) {
-        LOG_ERROR("server.loading", "[Ollama Chat] GenerateBotPrompt: template is empty");
-        return "";
+        return snapshot;
     }
 
     AreaTableEntry const* botCurrentArea = botAI->GetCurrentArea();
     AreaTableEntry const* botCurrentZone = botAI->GetCurrentZone();
 
-    uint64_t botGuid                = bot->GetGUID().GetRawValue();
-    uint64_t playerGuid             = player->GetGUID().GetRawValue();
-
-    std::string personality         = GetBotPersonality(bot);
-    std::string personalityPrompt   = GetPersonalityPromptAddition(personality);
-    std::string botName             = bot->GetName();
-    uint32_t botLevel               = bot->GetLevel();
-    uint8_t botGenderByte           = bot->getGender();
-    std::string botAreaName         = botCurrentArea ? botAI->GetLocalizedAreaName(botCurrentArea): "UnknownArea";
-    std::string botZoneName         = botCurrentZone ? botAI->GetLocalizedAreaName(botCurrentZone): "UnknownZone";
-    std::string botMapName          = bot->GetMap() ? bot->GetMap()->GetMapName() : "UnknownMap";
-    std::string botClass            = botAI->GetChatHelper()->FormatClass(bot->getClass());
-    std::string botRace             = botAI->GetChatHelper()->FormatRace(bot->getRace());
-    std::string botRole             = ChatHelper::FormatClass(bot, AiFactory::GetPlayerSpecTab(bot));
-    std::string botGender           = (botGenderByte == 0 ? "Male" : "Female");
-    std::string botFaction          = (bot->GetTeamId() == TEAM_ALLIANCE ? "Alliance" : "Horde");
-    std::string botGuild            = (bot->GetGuild() ? bot->GetGuild()->GetName() : "No Guild");
-    std::string botGroupStatus      = (bot->GetGroup() ? "In a group" : "Solo");
-    uint32_t botGold                = bot->GetMoney() / 10000;
-
-    std::string playerName          = player->GetName();
-    uint32_t playerLevel            = player->GetLevel();
-    std::string playerClass         = botAI->GetChatHelper()->FormatClass(player->getClass());
-    std::string playerRace          = botAI->GetChatHelper()->FormatRace(player->getRace());
-    std::string playerRole          = ChatHelper::FormatClass(player, AiFactory::GetPlayerSpecTab(player));
-    uint8_t playerGenderByte        = player->getGender();
-    std::string playerGender        = (playerGenderByte == 0 ? "Male" : "Female");
-    std::string playerFaction       = (player->GetTeamId() == TEAM_ALLIANCE ? "Alliance" : "Horde");
-    std::string playerGuild         = (player->GetGuild() ? player->GetGuild()->GetName() : "No Guild");
-    std::string playerGroupStatus   = (player->GetGroup() ? "In a group" : "Solo");
-    uint32_t playerGold             = player->GetMoney() / 10000;
-    float playerDistance            = player->IsInWorld() && bot->IsInWorld() ? player->GetDistance(bot) : -1.0f;
-
-    std::string chatHistory         = GetBotHistoryPrompt(botGuid, playerGuid, playerMessage);
-    std::string sentimentInfo       = GetSentimentPromptAddition(bot, player);
+    snapshot.valid                  = true;
+    snapshot.config                 = GetOllamaPromptConfig();
+    snapshot.botGuid                = bot->GetGUID().GetRawValue();
+    snapshot.playerGuid             = player->GetGUID().GetRawValue();
+    snapshot.playerMessage          = std::move(playerMessage);
+
+    snapshot.personality            = GetBotPersonality(bot);
+    snapshot.personalityPrompt      = GetPersonalityPromptAddition(snapshot.personality);
+    snapshot.botName                = bot->GetName();
+    snapshot.botLevel               = bot->GetLevel();
+    snapshot.botAreaName            = botCurrentArea ? botAI->GetLocalizedAreaName(botCurrentArea): "UnknownArea";
+    snapshot.botZoneName            = botCurrentZone ? botAI->GetLocalizedAreaName(botCurrentZone): "UnknownZone";
+    snapshot.botMapName             = bot->GetMap() ? bot->GetMap()->GetMapName() : "UnknownMap";
+    snapshot.botClass               = helper->FormatClass(bot->getClass());
+    snapshot.botRace                = helper->FormatRace(bot->getRace());
+    snapshot.botRole                = ChatHelper::FormatClass(bot, AiFactory::GetPlayerSpecTab(bot));
+    snapshot.botGender              = (bot->getGender() == 0 ? "Male" : "Female");
+    snapshot.botFaction             = (bot->GetTeamId() == TEAM_ALLIANCE ? "Alliance" : "Horde");
+    snapshot.botGuild               = (bot->GetGuild() ? bot->GetGuild()->GetName() : "No Guild");
+    snapshot.botGroupStatus         = (bot->GetGroup() ? "In a group" : "Solo");
+    snapshot.botGold                = bot->GetMoney() / 10000;
+
+    snapshot.playerName             = player->GetName();
+    snapshot.playerLevel            = player->GetLevel();
+    snapshot.playerClass            = helper->FormatClass(player->getClass());
+    snapshot.playerRace             = helper->FormatRace(player->getRace());
+    snapshot.playerRole             = ChatHelper::FormatClass(player, AiFactory::GetPlayerSpecTab(player));
+    snapshot.playerGender           = (player->getGender() == 0 ? "Male" : "Female");
+    snapshot.playerFaction          = (player->GetTeamId() == TEAM_ALLIANCE ? "Alliance" : "Horde");
+    snapshot.playerGuild            = (player->GetGuild() ? player->GetGuild()->GetName() : "No Guild");
+    snapshot.playerGroupStatus      = (player->GetGroup() ? "In a group" : "Solo");
+    snapshot.playerGold             = player->GetMoney() / 10000;
+    snapshot.playerDistance         = player->IsInWorld() && bot->IsInWorld() ? player->GetDistance(bot) : -1.0f;
+
+    snapshot.sentimentInfo          = GetSentimentPromptAddition(bot, player);
+
+    if(g_EnableChatBotSnapshotTemplate)
+    {
+        snapshot.hasGameState = true;
+        snapshot.gameState = CaptureBotGameStateSnapshot(bot);
+    }
+
+    return snapshot;
+}
+
+OllamaRequest BuildBotPromptRequest(const BotPromptSnapshot& snapshot)
+{
+    OllamaRequest request;
+    if (!snapshot.valid) {
+        return request;
+    }
+    const OllamaPromptConfig& config = *snapshot.config;
+    const std::string& promptTemplate = config.enableSplitPrompt ? config.chatTurnTemplate : config.chatPromptTemplate;
+    if (promptTemplate.empty()) {
+        LOG_ERROR("server.loading", "[Ollama Chat] BuildBotPromptRequest: template is empty");
+        return request;
+    }
+
+    const std::string& playerMessage = snapshot.playerMessage;
+
+    // In chat mode the history travels as messages instead of being rendered into the prompt
+    std::string chatHistory;
+    if (config.useChatEndpoint)
+        request.history             = GetBotHistoryMessages(config, snapshot.botGuid, snapshot.playerGuid);
+    else
+        chatHistory                 = GetBotHistoryPrompt(config, snapshot.botGuid, snapshot.playerGuid, snapshot.playerName, playerMessage);
 
     // Retrieve RAG information if enabled
     std::string ragInfo;
-    if (g_EnableRAG && g_RAGSystem) {
-        auto ragResults = g_RAGSystem->RetrieveRelevantInfo(playerMessage, g_RAGMaxRetrievedItems, g_RAGSimilarityThreshold);
+    if (config.enableRAG && g_RAGSystem) {
+        auto ragResults = g_RAGSystem->RetrieveRelevantInfo(playerMessage, config.ragMaxRetrievedItems, config.ragSimilarityThreshold);
         std::string ragContent = g_RAGSystem->GetFormattedRAGInfo(ragResults);
         if (!ragContent.empty()) {
-            ragInfo = SafeFormat(g_RAGPromptTemplate, fmt::arg("rag_info", ragContent));
+            ragInfo = SafeFormat(config.ragPromptTemplate, fmt::arg("rag_info", ragContent));
         }
         if (g_DebugEnabled) {
             LOG_INFO("server.loading", "[Ollama Chat] RAG Debug - Enabled: {}, System: {}, Message: '{}', Results: {}, Content length: {}",
-                g_EnableRAG, (void*)g_RAGSystem, playerMessage, ragResults.size(), ragContent.length());
+                config.enableRAG, (void*)g_RAGSystem, playerMessage, ragResults.size(), ragContent.length());
         }
     } else if (g_DebugEnabled) {
         LOG_INFO("server.loading", "[Ollama Chat] RAG Debug - Not enabled or no system - Enabled: {}, System: {}",
-            g_EnableRAG, (void*)g_RAGSystem);
+            config.enableRAG, (void*)g_RAGSystem);
     }
 
     std::string extraInfo = SafeFormat(
-        g_ChatExtraInfoTemplate,
-        fmt::arg("bot_race", botRace),
-        fmt::arg("bot_gender", botGender),
-        fmt::arg("bot_role", botRole),
-        fmt::arg("bot_faction", botFaction),
-        fmt::arg("bot_guild", botGuild),
-        fmt::arg("bot_group_status", botGroupStatus),
-        fmt::arg("bot_gold", botGold),
-        fmt::arg("player_race", playerRace),
-        fmt::arg("player_gender", playerGender),
-        fmt::arg("player_role", playerRole),
-        fmt::arg("player_faction", playerFaction),
-        fmt::arg("player_guild", playerGuild),
-        fmt::arg("player_group_status", playerGroupStatus),
-        fmt::arg("player_gold", playerGold),
-        fmt::arg("player_distance", playerDistance),
-        fmt::arg("bot_area", botAreaName),
-        fmt::arg("bot_zone", botZoneName),
-        fmt::arg("bot_map", botMapName)
+        config.chatExtraInfoTemplate,
+        fmt::arg("bot_race", snapshot.botRace),
+        fmt::arg("bot_gender", snapshot.botGender),
+        fmt::arg("bot_role", snapshot.botRole),
+        fmt::arg("bot_faction", snapshot.botFaction),
+        fmt::arg("bot_guild", snapshot.botGuild),
+        fmt::arg("bot_group_status", snapshot.botGroupStatus),
+        fmt::arg("bot_gold", snapshot.botGold),
+        fmt::arg("player_race", snapshot.playerRace),
+        fmt::arg("player_gender", snapshot.playerGender),
+        fmt::arg("player_role", snapshot.playerRole),
+        fmt::arg("player_faction", snapshot.playerFaction),
+        fmt::arg("player_guild", snapshot.playerGuild),
+        fmt::arg("player_group_status", snapshot.playerGroupStatus),
+        fmt::arg("player_gold", snapshot.playerGold),
+        fmt::arg("player_distance", snapshot.playerDistance),
+        fmt::arg("bot_area", snapshot.botAreaName),
+        fmt::arg("bot_zone", snapshot.botZoneName),
+        fmt::arg("bot_map", snapshot.botMapName)
     );
-    
+
     std::string prompt = SafeFormat(
-        g_ChatPromptTemplate,
-        fmt::arg("bot_name", botName),
-        fmt::arg("bot_level", botLevel),
-        fmt::arg("bot_class", botClass),
-        fmt::arg("bot_personality", personalityPrompt),
-        fmt::arg("bot_personality_name", personality),
-        fmt::arg("player_level", playerLevel),
-        fmt::arg("player_class", playerClass),
-        fmt::arg("player_name", playerName),
+        promptTemplate,
+        fmt::arg("bot_name", snapshot.botName),
+        fmt::arg("bot_level", snapshot.botLevel),
+        fmt::arg("bot_class", snapshot.botClass),
+        fmt::arg("bot_personality", snapshot.personalityPrompt),
+        fmt::arg("bot_personality_name", snapshot.personality),
+        fmt::arg("player_level", snapshot.playerLevel),
+        fmt::arg("player_class", snapshot.playerClass),
+        fmt::arg("player_name", snapshot.playerName),
         fmt::arg("player_message", playerMessage),
         fmt::arg("extra_info", extraInfo),
         fmt::arg("chat_history", chatHistory),
-        fmt::arg("sentiment_info", sentimentInfo)
+        fmt::arg("sentiment_info", snapshot.sentimentInfo)
     );
 
+    // In split mode the persona goes into the system field. It only changes when the
+    // bot levels or gets a new personality, so Ollama can reuse the cached prefix.
+    if (config.enableSplitPrompt)
+    {
+        request.system = SafeFormat(
+            config.chatSystemTemplate,
+            fmt::arg("bot_name", snapshot.botName),
+            fmt::arg("bot_level", snapshot.botLevel),
+            fmt::arg("bot_class", snapshot.botClass),
+            fmt::arg("bot_race", snapshot.botRace),
+            fmt::arg("bot_gender", snapshot.botGender),
+            fmt::arg("bot_faction", snapshot.botFaction),
+            fmt::arg("bot_personality", snapshot.personalityPrompt),
+            fmt::arg("bot_personality_name", snapshot.personality)
+        );
+        if (!config.systemPrompt.empty())
+        {
+            request.system = config.systemPrompt + "\n" + request.system;
+        }
+    }
+
     // Add RAG information to the prompt if available
     if (!ragInfo.empty()) {
         prompt += ragInfo + "\n";
     }
 
-    if(g_EnableChatBotSnapshotTemplate)
+    if(snapshot.hasGameState)
     {
-        prompt += GenerateBotGameStateSnapshot(bot);
+        prompt += FormatBotGameStateSnapshot(config.chatBotSnapshotTemplate, snapshot.gameState);
     }
 
     // Debug logging for full prompt including RAG information
-    if (g_DebugEnabled && g_DebugShowFullPrompt) {
-        LOG_INFO("server.loading", "[Ollama Chat] Full prompt sent to bot {} for player {}: {}", botName, playerName, prompt);
+    if (g_DebugEnabled && config.debugShowFullPrompt) {
+        if (!request.system.empty()) {
+            LOG_INFO("server.loading", "[Ollama Chat] System prompt for bot {}: {}", snapshot.botName, request.system);
+        }
+        LOG_INFO("server.loading", "[Ollama Chat] Full prompt sent to bot {} for player {}: {}", snapshot.botName, snapshot.playerName, prompt);
     }
 
-    return prompt;
+    request.prompt = std::move(prompt);
+    return request;
 }
@@ -23,6 +23,18 @@ std::string rtrim(const std::string& s);
 ChatChannelSourceLocal GetChannelSourceLocal(uint32_t type);
 void ProcessBotChatMessage(Player* bot, const std::string& msg, ChatChannelSourceLocal sourceLocal, Channel* channel);
 
+// Whether RouteBotReply sends the reply, lets other bots answer it, or both
+enum BotReplyRouting
+{
+    BOT_REPLY_SEND_AND_NOTIFY,
+    BOT_REPLY_SEND_ONLY,
+    BOT_REPLY_NOTIFY_ONLY
+};
+
+void RouteBotReply(Player* bot, uint64_t senderGuid, ChatChannelSourceLocal sourceLocal, uint32_t channelId,
+                   const std::string& channelName, const std::string& response,
+                   BotReplyRouting routing = BOT_REPLY_SEND_AND_NOTIFY);
+
 void SaveBotConversationHistoryToDB();
 
 class PlayerBotChatHandler : public PlayerScript
@@ -44,4 +56,15 @@ public:
     static void ProcessChat(Player* player, uint32_t type, uint32_t lang, std::string& msg, ChatChannelSourceLocal sourceLocal, Channel* channel = nullptr, Player* receiver = nullptr);
 };
 
+// Keeps the per-bot game state snapshot cache in step with the spell book.
+class OllamaSnapshotCacheTracker : public PlayerScript
+{
+public:
+    OllamaSnapshotCacheTracker();
+    void OnPlayerLearnSpell(Player* player, uint32 spellID) override;
+    void OnPlayerForgotSpell(Player* player, uint32 spellID) override;
+    void OnPlayerLevelChanged(Player* player, uint8 oldLevel) override;
+    void OnPlayerLogout(Player* player) override;
+};
+
 #endif // MOD_OLLAMA_CHAT_HANDLER_H
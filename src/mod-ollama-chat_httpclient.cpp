@@ -8,6 +8,7 @@
 #include <sstream>
 #include <regex>
 #include <memory>
+#include <chrono>
 
 OllamaHttpClient::OllamaHttpClient()
     : m_timeout(120), m_available(true)
@@ -17,137 +18,326 @@ OllamaHttpClient::OllamaHttpClient()
 
 OllamaHttpClient::~OllamaHttpClient()
 {
+    ClearPool();
 }
 
-std::string OllamaHttpClient::Post(const std::string& url, const std::string& jsonData)
+std::shared_ptr<const OllamaEndpoint> ParseOllamaEndpoint(const std::string& url)
 {
-    try 
+    static const std::regex urlRegex(R"(^(https?)://([^:/]+)(?::(\d+))?(/.*)?$)");
+    std::smatch match;
+
+    if (!std::regex_match(url, match, urlRegex))
     {
-        // Parse URL to extract host and path
-        std::regex urlRegex(R"(^(https?)://([^:/]+)(?::(\d+))?(/.*)?$)");
-        std::smatch match;
-        
-        if (!std::regex_match(url, match, urlRegex))
+        return nullptr;
+    }
+
+    auto endpoint = std::make_shared<OllamaEndpoint>();
+    endpoint->url = url;
+    endpoint->protocol = match[1].str();
+    endpoint->host = match[2].str();
+    if (match[3].matched)
+    {
+        try
         {
-            LOG_INFO("server.loading", "[Ollama Chat] Invalid URL format: {}", url);
-            return "";
+            endpoint->port = std::stoi(match[3].str());
         }
-        
-        std::string protocol = match[1].str();
-        std::string host = match[2].str();
-        int port = 11434;  // Default Ollama port
-        if (match[3].matched)
+        catch (const std::exception&)
         {
-            port = std::stoi(match[3].str());
+            return nullptr;
         }
-        else if (protocol == "https")
+    }
+    else if (endpoint->protocol == "https")
+    {
+        endpoint->port = 443;  // HTTPS default
+    }
+    else
+    {
+        endpoint->port = 11434;  // Ollama default port for HTTP
+    }
+    endpoint->path = match[4].matched ? match[4].str() : "/";
+    endpoint->poolKey = endpoint->protocol + "://" + endpoint->host + ":" + std::to_string(endpoint->port);
+    endpoint->isNgrok = endpoint->host.find("ngrok") != std::string::npos;
+    return endpoint;
+}
+
+std::string GetOllamaChatUrl(const std::string& url)
+{
+    static const std::string generateSuffix = "/api/generate";
+    static const std::string chatSuffix = "/api/chat";
+
+    // A trailing slash does not change which endpoint is meant
+    std::string base = url;
+    if (base.size() > 1 && base.back() == '/')
+        base.pop_back();
+
+    auto endsWith = [&base](const std::string& suffix) {
+        return base.size() >= suffix.size() &&
+               base.compare(base.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    if (endsWith(generateSuffix))
+        return base.substr(0, base.size() - generateSuffix.size()) + chatSuffix;
+    if (endsWith(chatSuffix))
+        return base;
+
+    // Bare server URLs (http://host:11434 or http://host:11434/) get the chat path appended
+    size_t schemeEnd = base.find("://");
+    if (schemeEnd != std::string::npos && base.find('/', schemeEnd + 3) == std::string::npos)
+        return base + chatSuffix;
+
+    // Any other path (a proxy route, for example) can't be mapped to /api/chat
+    return "";
+}
+
+std::unique_ptr<httplib::ClientImpl> OllamaHttpClient::CreateClient(const OllamaEndpoint& endpoint)
+{
+    const std::string& host = endpoint.host;
+    int port = endpoint.port;
+    std::unique_ptr<httplib::ClientImpl> client;
+
+    if (endpoint.protocol == "https")
+    {
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+        auto sslClient = std::make_unique<httplib::SSLClient>(host, port);
+        // Disable SSL verification for ngrok and self-signed certificates
+        sslClient->enable_server_certificate_verification(false);
+        client = std::move(sslClient);
+
+        if(g_DebugEnabled) {
+            LOG_INFO("server.loading", "[Ollama Chat] Created SSL client for {}:{}", host, port);
+        }
+#else
+        LOG_ERROR("server.loading", "[Ollama Chat] HTTPS requested but SSL support not available.");
+        LOG_ERROR("server.loading", "[Ollama Chat] Please rebuild with OpenSSL support enabled.");
+        LOG_ERROR("server.loading", "[Ollama Chat] See CMake output for OpenSSL installation instructions.");
+        return nullptr;
+#endif
+    }
+    else
+    {
+        client = std::make_unique<httplib::ClientImpl>(host, port);
+
+        if(g_DebugEnabled) {
+            LOG_INFO("server.loading", "[Ollama Chat] Created HTTP client for {}:{}", host, port);
+        }
+    }
+
+    client->set_connection_timeout(m_timeout);
+    client->set_read_timeout(m_timeout);
+    client->set_write_timeout(m_timeout);
+    client->set_keep_alive(g_HttpPoolSize > 0);
+    return client;
+}
+
+// A keep-alive socket the server or a proxy has closed still looks open on our
+// side; peek at it without blocking to see the FIN or reset.
+static bool IsPooledConnectionAlive(const httplib::ClientImpl& client)
+{
+    return client.is_socket_open() && httplib::detail::is_socket_alive(client.socket());
+}
+
+std::unique_ptr<httplib::ClientImpl> OllamaHttpClient::AcquireClient(const OllamaEndpoint& endpoint, bool& reused)
+{
+    reused = false;
+    if (g_HttpPoolSize > 0)
+    {
+        std::unique_ptr<httplib::ClientImpl> pooled;
+        std::vector<std::unique_ptr<httplib::ClientImpl>> expired;
+        {
+            std::lock_guard<std::mutex> lock(m_poolMutex);
+            auto it = m_idleClients.find(endpoint.poolKey);
+            if (it != m_idleClients.end())
+            {
+                auto now = std::chrono::steady_clock::now();
+                auto idleLimit = std::chrono::seconds(g_HttpPoolIdleTimeout);
+                std::vector<PooledClient>& idle = it->second;
+                while (!idle.empty())
+                {
+                    PooledClient entry = std::move(idle.back());
+                    idle.pop_back();
+
+                    // Servers close idle keep-alive sockets on their own; don't reuse past the idle limit
+                    if (g_HttpPoolIdleTimeout > 0 && now - entry.lastUsed > idleLimit)
+                    {
+                        expired.push_back(std::move(entry.client));
+                        continue;
+                    }
+                    if (g_HttpPoolHealthCheck && !IsPooledConnectionAlive(*entry.client))
+                    {
+                        expired.push_back(std::move(entry.client));
+                        continue;
+                    }
+                    pooled = std::move(entry.client);
+                    break;
+                }
+            }
+        }
+
+        // Close discarded connections outside the lock
+        for (auto& client : expired)
         {
-            port = 443;  // HTTPS default
+            client->stop();
         }
-        else if (protocol == "http")
+
+        if (pooled)
         {
-            port = 11434;  // Ollama default port for HTTP
+            if(g_DebugEnabled) {
+                LOG_INFO("server.loading", "[Ollama Chat] Reusing pooled connection to {} ({} stale dropped)", endpoint.poolKey, expired.size());
+            }
+            reused = true;
+            return pooled;
         }
-        
-        std::string path = match[4].matched ? match[4].str() : "/";
+    }
+
+    return CreateClient(endpoint);
+}
+
+void OllamaHttpClient::ReleaseClient(const std::string& poolKey, std::unique_ptr<httplib::ClientImpl> client, bool healthy)
+{
+    if (!client)
+        return;
+
+    if (healthy && g_HttpPoolSize > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        std::vector<PooledClient>& idle = m_idleClients[poolKey];
+        if (idle.size() < g_HttpPoolSize)
+        {
+            idle.push_back({ std::move(client), std::chrono::steady_clock::now() });
+            return;
+        }
+    }
+
+    client->stop();
+}
+
+void OllamaHttpClient::ClearPool()
+{
+    std::unordered_map<std::string, std::vector<PooledClient>> idleClients;
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        idleClients.swap(m_idleClients);
+    }
+    for (auto& hostEntry : idleClients)
+    {
+        for (PooledClient& entry : hostEntry.second)
+        {
+            entry.client->stop();
+        }
+    }
+}
+
+static httplib::Headers BuildHeaders(const OllamaEndpoint& endpoint)
+{
+    // Set headers (with ngrok-specific headers)
+    httplib::Headers headers = {
+        {"Content-Type", "application/json"},
+        {"User-Agent", "AzerothCore-OllamaChat/1.0"},
+        {"Accept", "application/json"}
+    };
+
+    // Add ngrok bypass header if this is an ngrok URL
+    if (endpoint.isNgrok) {
+        headers.emplace("ngrok-skip-browser-warning", "true");
+    }
+    return headers;
+}
+
+// How soon after sending a read error still means the server had closed the
+// connection, rather than a request that timed out while generating
+static constexpr std::chrono::seconds STALE_READ_WINDOW(2);
+
+// Whether a request that failed on a pooled connection failed because the
+// server had already closed it. Only those are worth sending again: a read
+// that fails after the model has been generating for a while is a timeout on
+// a working connection, and sending again would repeat the whole generation.
+static bool IsStaleConnectionError(httplib::Error error, std::chrono::steady_clock::time_point sentAt)
+{
+    switch (error)
+    {
+        case httplib::Error::Connection:
+        case httplib::Error::Write:
+            return true;
+        case httplib::Error::Read:
+            return std::chrono::steady_clock::now() - sentAt < STALE_READ_WINDOW;
+        default:
+            return false;
+    }
+}
+
+std::string OllamaHttpClient::Post(const OllamaEndpoint& endpoint, const std::string& jsonData)
+{
+    try 
+    {
+        const std::string& host = endpoint.host;
+        int port = endpoint.port;
+        const std::string& path = endpoint.path;
         
         if(g_DebugEnabled)
         {
             LOG_INFO("server.loading", "[Ollama Chat] HTTP Request - Protocol: {}, Host: {}, Port: {}, Path: {}", 
-                protocol, host, port, path);
+                endpoint.protocol, host, port, path);
         }
         
-        // Create HTTP client (with SSL support for HTTPS)
-        httplib::Result response;
-        
-        if (protocol == "https") {
-#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
-            httplib::SSLClient sslClient(host, port);
-            // Disable SSL verification for ngrok and self-signed certificates
-            sslClient.enable_server_certificate_verification(false);
-            sslClient.set_connection_timeout(m_timeout);
-            sslClient.set_read_timeout(m_timeout);
-            sslClient.set_write_timeout(m_timeout);
-            
-            if(g_DebugEnabled) {
-                LOG_INFO("server.loading", "[Ollama Chat] Using SSL client for HTTPS connection");
-            }
-            
-            // Set headers (with ngrok-specific headers)
-            httplib::Headers headers = {
-                {"Content-Type", "application/json"},
-                {"User-Agent", "AzerothCore-OllamaChat/1.0"},
-                {"Accept", "application/json"}
-            };
-            
-            // Add ngrok bypass header if this is an ngrok URL
-            if (host.find("ngrok") != std::string::npos || host.find("ngrok-free.app") != std::string::npos) {
-                headers.emplace("ngrok-skip-browser-warning", "true");
-                if(g_DebugEnabled) {
-                    LOG_INFO("server.loading", "[Ollama Chat] Added ngrok bypass header");
-                }
-            }
-            
-            // Make POST request with SSL client
-            response = sslClient.Post(path, headers, jsonData, "application/json");
-#else
-            LOG_ERROR("server.loading", "[Ollama Chat] HTTPS requested but SSL support not available.");
-            LOG_ERROR("server.loading", "[Ollama Chat] Please rebuild with OpenSSL support enabled.");
-            LOG_ERROR("server.loading", "[Ollama Chat] See CMake output for OpenSSL installation instructions.");
+        bool reused = false;
+        std::unique_ptr<httplib::ClientImpl> client = AcquireClient(endpoint, reused);
+        if (!client)
+        {
             return "";
-#endif
-        } else {
-            httplib::Client client(host, port);
-            client.set_connection_timeout(m_timeout);
-            client.set_read_timeout(m_timeout);
-            client.set_write_timeout(m_timeout);
-            
-            if(g_DebugEnabled) {
-                LOG_INFO("server.loading", "[Ollama Chat] Using standard HTTP client");
+        }
+        
+        auto sentAt = std::chrono::steady_clock::now();
+        httplib::Result response = client->Post(path, BuildHeaders(endpoint), jsonData, "application/json");
+        
+        // The server can close a pooled connection between the health check and
+        // the request; try once more on a fresh connection before giving up
+        if (!response && reused && IsStaleConnectionError(response.error(), sentAt))
+        {
+            if(g_DebugEnabled)
+            {
+                LOG_INFO("server.loading", "[Ollama Chat] Pooled connection to {} failed ({}), retrying on a new connection",
+                    endpoint.poolKey, httplib::to_string(response.error()));
             }
-            
-            // Set headers (with ngrok-specific headers)
-            httplib::Headers headers = {
-                {"Content-Type", "application/json"},
-                {"User-Agent", "AzerothCore-OllamaChat/1.0"},
-                {"Accept", "application/json"}
-            };
-            
-            // Add ngrok bypass header if this is an ngrok URL
-            if (host.find("ngrok") != std::string::npos || host.find("ngrok-free.app") != std::string::npos) {
-                headers.emplace("ngrok-skip-browser-warning", "true");
-                if(g_DebugEnabled) {
-                    LOG_INFO("server.loading", "[Ollama Chat] Added ngrok bypass header");
-                }
+            client->stop();
+            client = CreateClient(endpoint);
+            if (!client)
+            {
+                return "";
             }
-            
-            // Make POST request with regular client
-            response = client.Post(path, headers, jsonData, "application/json");
+            response = client->Post(path, BuildHeaders(endpoint), jsonData, "application/json");
         }
         
+        // Only connections that completed a normal exchange go back to the pool
+        bool healthy = response && response->status < 500;
+        
         if (!response)
         {
-            LOG_ERROR("server.loading", "[Ollama Chat] HTTP request failed - no response from {}:{}{}", host, port, path);
+            LOG_ERROR("server.loading", "[Ollama Chat] HTTP request failed - no response from {}:{}{} ({})", host, port, path,
+                httplib::to_string(response.error()));
+            ReleaseClient(endpoint.poolKey, std::move(client), false);
             return "";
         }
         
-        if (response->status != 200)
+        int status = response->status;
+        std::string body = std::move(response->body);
+        ReleaseClient(endpoint.poolKey, std::move(client), healthy);
+        
+        if (status != 200)
         {
             LOG_ERROR("server.loading", "[Ollama Chat] HTTP request failed with status: {} for {}:{}{}", 
-                response->status, host, port, path);
+                status, host, port, path);
             if(g_DebugEnabled)
             {
-                LOG_INFO("server.loading", "[Ollama Chat] Response body: {}", response->body);
+                LOG_INFO("server.loading", "[Ollama Chat] Response body: {}", body);
             }
             return "";
         }
         
         if(g_DebugEnabled)
         {
-            LOG_INFO("server.loading", "[Ollama Chat] HTTP request successful, response length: {}", response->body.length());
+            LOG_INFO("server.loading", "[Ollama Chat] HTTP request successful, response length: {}", body.length());
         }
         
-        return response->body;
+        return body;
     }
     catch (const std::exception& e)
     {
@@ -156,6 +346,85 @@ std::string OllamaHttpClient::Post(const std::string& url, const std::string& js
     }
 }
 
+bool OllamaHttpClient::PostStream(const OllamaEndpoint& endpoint, const std::string& jsonData,
+                                  const std::function<bool(const char*, size_t)>& onData)
+{
+    try
+    {
+        if(g_DebugEnabled)
+        {
+            LOG_INFO("server.loading", "[Ollama Chat] HTTP Stream Request - Protocol: {}, Host: {}, Port: {}, Path: {}",
+                endpoint.protocol, endpoint.host, endpoint.port, endpoint.path);
+        }
+
+        bool reused = false;
+        std::unique_ptr<httplib::ClientImpl> client = AcquireClient(endpoint, reused);
+        if (!client)
+        {
+            return false;
+        }
+
+        // Error bodies are delivered to onData as well; Ollama sends them as a JSON object with an "error" field
+        bool received = false;
+        auto post = [&]() {
+            return client->Post(endpoint.path, BuildHeaders(endpoint), jsonData, "application/json",
+                [&onData, &received](const char* data, size_t length) -> bool {
+                    received = true;
+                    return onData(data, length);
+                });
+        };
+        auto sentAt = std::chrono::steady_clock::now();
+        httplib::Result response = post();
+
+        // A pooled connection closed by the server fails before any data arrives;
+        // only then is it safe to send the request again on a fresh connection
+        if (!response && reused && !received && IsStaleConnectionError(response.error(), sentAt))
+        {
+            if(g_DebugEnabled)
+            {
+                LOG_INFO("server.loading", "[Ollama Chat] Pooled connection to {} failed ({}), retrying on a new connection",
+                    endpoint.poolKey, httplib::to_string(response.error()));
+            }
+            client->stop();
+            client = CreateClient(endpoint);
+            if (!client)
+            {
+                return false;
+            }
+            response = post();
+        }
+
+        if (!response)
+        {
+            // A cancelled stream leaves the connection mid-response, so it is never pooled
+            ReleaseClient(endpoint.poolKey, std::move(client), false);
+            if (response.error() == httplib::Error::Canceled)
+            {
+                return true;
+            }
+            LOG_ERROR("server.loading", "[Ollama Chat] HTTP stream failed - no response from {}:{}{} ({})", endpoint.host,
+                endpoint.port, endpoint.path, httplib::to_string(response.error()));
+            return false;
+        }
+
+        int status = response->status;
+        ReleaseClient(endpoint.poolKey, std::move(client), status < 500);
+
+        if (status != 200)
+        {
+            LOG_ERROR("server.loading", "[Ollama Chat] HTTP stream failed with status: {} for {}:{}{}",
+                status, endpoint.host, endpoint.port, endpoint.path);
+            return false;
+        }
+        return true;
+    }
+    catch (const std::exception& e)
+    {
+        LOG_ERROR("server.loading", "[Ollama Chat] HTTP client exception: {}", e.what());
+        return false;
+    }
+}
+
 void OllamaHttpClient::SetTimeout(int seconds)
 {
     m_timeout = seconds;
@@ -164,4 +433,4 @@ void OllamaHttpClient::SetTimeout(int seconds)
 bool OllamaHttpClient::IsAvailable() const
 {
     return m_available;
-}
\ No newline at end of file
+}
@@ -2,6 +2,37 @@
 #define OLLAMA_HTTP_CLIENT_H
 
 #include <string>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <chrono>
+#include <unordered_map>
+#include <functional>
+
+namespace httplib
+{
+    class ClientImpl;
+}
+
+// An Ollama URL split into its parts. Parsed once when the config is loaded
+// and never modified afterwards, so it can be shared freely between threads.
+struct OllamaEndpoint
+{
+    std::string url;
+    std::string protocol;
+    std::string host;
+    int port = 11434;
+    std::string path = "/";
+    std::string poolKey; // protocol://host:port, identifies the connection pool
+    bool isNgrok = false;
+};
+
+// Parse a URL of the form http(s)://host[:port][/path]. Returns nullptr if the URL is invalid.
+std::shared_ptr<const OllamaEndpoint> ParseOllamaEndpoint(const std::string& url);
+
+// The /api/chat URL on the same server as a /api/generate or bare server URL,
+// ignoring a trailing slash. Empty if the path is anything else.
+std::string GetOllamaChatUrl(const std::string& url);
 
 class OllamaHttpClient
 {
@@ -10,17 +41,43 @@ public:
     ~OllamaHttpClient();
 
     // Make HTTP POST request to Ollama API
-    std::string Post(const std::string& url, const std::string& jsonData);
+    std::string Post(const OllamaEndpoint& endpoint, const std::string& jsonData);
+
+    // Make HTTP POST request and hand the body to onData as it arrives.
+    // Returning false from onData cancels the request. Returns true if the
+    // request succeeded or was cancelled by onData.
+    bool PostStream(const OllamaEndpoint& endpoint, const std::string& jsonData,
+                    const std::function<bool(const char*, size_t)>& onData);
     
     // Set timeout for requests (in seconds)
     void SetTimeout(int seconds);
+    int GetTimeout() const { return m_timeout; }
     
     // Check if HTTP client is available
     bool IsAvailable() const;
 
+    // Drop all pooled keep-alive connections
+    void ClearPool();
+
 private:
+    struct PooledClient
+    {
+        std::unique_ptr<httplib::ClientImpl> client;
+        std::chrono::steady_clock::time_point lastUsed;
+    };
+
+    // Take an idle keep-alive client for the host from the pool, or create a new one.
+    // reused tells the caller whether the connection came from the pool.
+    std::unique_ptr<httplib::ClientImpl> AcquireClient(const OllamaEndpoint& endpoint, bool& reused);
+    // Return a client to the pool; unhealthy clients and clients beyond the pool size are closed
+    void ReleaseClient(const std::string& poolKey, std::unique_ptr<httplib::ClientImpl> client, bool healthy);
+    std::unique_ptr<httplib::ClientImpl> CreateClient(const OllamaEndpoint& endpoint);
+
     int m_timeout;
     bool m_available;
+
+    std::mutex m_poolMutex;
+    std::unordered_map<std::string, std::vector<PooledClient>> m_idleClients; // keyed by protocol://host:port
 };
 
-#endif // OLLAMA_HTTP_CLIENT_H
\ No newline at end of file
+#endif // OLLAMA_HTTP_CLIENT_H
@@ -0,0 +1,262 @@
+#include "mod-ollama-chat_loadbalancer.h"
+#include "mod-ollama-chat_httpclient.h"
+#include "mod-ollama-chat_config.h"
+#include "Log.h"
+#include <algorithm>
+#include <sstream>
+
+OllamaLoadBalancer g_LoadBalancer;
+
+// Weight of the latency estimate given to the newest sample.
+static constexpr double LATENCY_EWMA_ALPHA = 0.3;
+
+static std::string TrimBackendField(const std::string& str)
+{
+    size_t start = str.find_first_not_of(" \t\"");
+    if (start == std::string::npos)
+        return "";
+    size_t end = str.find_last_not_of(" \t\"");
+    return str.substr(start, end - start + 1);
+}
+
+std::vector<std::shared_ptr<OllamaBackend>> ParseOllamaBackends(const std::string& backendList)
+{
+    std::vector<std::shared_ptr<OllamaBackend>> backends;
+    std::stringstream list(backendList);
+    std::string entry;
+
+    while (std::getline(list, entry, ','))
+    {
+        entry = TrimBackendField(entry);
+        if (entry.empty())
+            continue;
+
+        std::vector<std::string> fields;
+        std::stringstream entryStream(entry);
+        std::string field;
+        while (std::getline(entryStream, field, '|'))
+        {
+            fields.push_back(TrimBackendField(field));
+        }
+
+        auto backend = std::make_shared<OllamaBackend>();
+        backend->endpoint = ParseOllamaEndpoint(fields[0]);
+        if (!backend->endpoint)
+        {
+            LOG_ERROR("server.loading", "[Ollama Chat] Skipping invalid backend URL '{}' in OllamaChat.Backends", fields[0]);
+            continue;
+        }
+        std::string chatUrl = GetOllamaChatUrl(fields[0]);
+        if (!chatUrl.empty())
+            backend->chatEndpoint = ParseOllamaEndpoint(chatUrl);
+        if (!backend->chatEndpoint && g_UseChatEndpoint)
+        {
+            LOG_ERROR("server.loading", "[Ollama Chat] OllamaChat.UseChatEndpoint is enabled but no /api/chat URL can be derived from "
+                      "backend URL '{}'; it must end in /api/generate or /api/chat or have no path. Requests to it use /api/generate.", fields[0]);
+        }
+
+        try
+        {
+            if (fields.size() > 1 && !fields[1].empty())
+                backend->weight = std::max<uint32_t>(1, static_cast<uint32_t>(std::stoul(fields[1])));
+            if (fields.size() > 2 && !fields[2].empty())
+                backend->maxConcurrent = static_cast<uint32_t>(std::stoul(fields[2]));
+        }
+        catch (const std::exception&)
+        {
+            LOG_ERROR("server.loading", "[Ollama Chat] Invalid weight or concurrency in backend entry '{}', using defaults", entry);
+        }
+
+        backends.push_back(std::move(backend));
+    }
+
+    return backends;
+}
+
+void OllamaLoadBalancer::Configure(std::vector<std::shared_ptr<OllamaBackend>> backends, BackendSelection selection,
+                                   uint32_t failureThreshold, uint32_t retryIntervalSeconds)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_backends = std::move(backends);
+        m_selection = selection;
+        m_failureThreshold = std::max<uint32_t>(1, failureThreshold);
+        m_retryInterval = std::chrono::seconds(retryIntervalSeconds);
+    }
+    // Waiting requests get to pick from the new list
+    m_capacityFreed.notify_all();
+}
+
+std::shared_ptr<OllamaBackend> OllamaLoadBalancer::Acquire(std::chrono::seconds maxWait)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    auto deadline = std::chrono::steady_clock::now() + maxWait;
+    std::shared_ptr<OllamaBackend> best;
+    bool bestIsProbe = false;
+    for (;;)
+    {
+        if (m_stopping)
+            return nullptr;
+
+        auto now = std::chrono::steady_clock::now();
+        double bestScore = 0.0;
+        bool healthyAtCap = false;
+        // Nothing releases a slot when a down backend becomes due for its
+        // probe, so a waiter has to wake up for that itself
+        auto wakeAt = deadline;
+
+        for (const auto& backend : m_backends)
+        {
+            bool probe = false;
+            if (backend->down)
+            {
+                // Let a single trial request through once the retry interval has passed
+                if (backend->probing)
+                    continue;
+                if (now < backend->retryAt)
+                {
+                    wakeAt = std::min(wakeAt, backend->retryAt);
+                    continue;
+                }
+                probe = true;
+            }
+
+            if (backend->maxConcurrent > 0 && backend->outstanding >= backend->maxConcurrent)
+            {
+                healthyAtCap = healthyAtCap || !backend->down;
+                continue;
+            }
+
+            double load = static_cast<double>(backend->outstanding + 1) / backend->weight;
+            double score = load;
+            if (m_selection == BackendSelection::LatencyEwma)
+            {
+                // Backends without samples yet count as fast so they get tried
+                score = load * std::max(1.0, backend->latencyEwmaMs);
+            }
+
+            if (!best || score < bestScore)
+            {
+                best = backend;
+                bestScore = score;
+                bestIsProbe = probe;
+            }
+        }
+
+        if (best)
+            break;
+        if (!healthyAtCap)
+            return nullptr;
+
+        if (now >= deadline)
+        {
+            LOG_ERROR("server.loading", "[Ollama Chat] No backend slot freed up within {}s, dropping the request", maxWait.count());
+            return nullptr;
+        }
+
+        // Every healthy backend is full; wait for one of them to finish a request
+        if (g_DebugEnabled)
+        {
+            LOG_INFO("server.loading", "[Ollama Chat] All backends at their concurrency cap, waiting for a free slot");
+        }
+        m_capacityFreed.wait_until(lock, wakeAt);
+    }
+
+    if (bestIsProbe)
+    {
+        best->probing = true;
+        if (g_DebugEnabled)
+        {
+            LOG_INFO("server.loading", "[Ollama Chat] Probing backend {} after failures", best->endpoint->url);
+        }
+    }
+
+    ++best->outstanding;
+    ++best->requests;
+    return best;
+}
+
+void OllamaLoadBalancer::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_capacityFreed.notify_all();
+}
+
+void OllamaLoadBalancer::Release(const std::shared_ptr<OllamaBackend>& backend, bool success, uint64_t latencyMs)
+{
+    if (!backend)
+        return;
+
+    // A slot is free either way; a backend going down also changes what a waiter can pick
+    struct NotifyOnExit
+    {
+        std::condition_variable& freed;
+        ~NotifyOnExit() { freed.notify_all(); }
+    } notify{ m_capacityFreed };
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (backend->outstanding > 0)
+        --backend->outstanding;
+
+    bool wasProbe = backend->probing;
+    backend->probing = false;
+
+    if (success)
+    {
+        if (backend->latencyEwmaMs <= 0.0)
+            backend->latencyEwmaMs = static_cast<double>(latencyMs);
+        else
+            backend->latencyEwmaMs += LATENCY_EWMA_ALPHA * (static_cast<double>(latencyMs) - backend->latencyEwmaMs);
+
+        if (backend->down)
+        {
+            LOG_INFO("server.loading", "[Ollama Chat] Backend {} is back in rotation", backend->endpoint->url);
+        }
+        backend->consecutiveFailures = 0;
+        backend->down = false;
+        return;
+    }
+
+    ++backend->failures;
+    ++backend->consecutiveFailures;
+    if (wasProbe || (!backend->down && backend->consecutiveFailures >= m_failureThreshold))
+    {
+        if (!backend->down)
+        {
+            LOG_ERROR("server.loading", "[Ollama Chat] Backend {} taken out of rotation after {} consecutive failures, retrying in {}s",
+                      backend->endpoint->url, backend->consecutiveFailures, m_retryInterval.count());
+        }
+        backend->down = true;
+        backend->retryAt = std::chrono::steady_clock::now() + m_retryInterval;
+    }
+}
+
+uint32_t OllamaLoadBalancer::GetTotalCapacity()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t total = 0;
+    for (const auto& backend : m_backends)
+    {
+        if (backend->maxConcurrent == 0)
+            return 0;
+        total += backend->maxConcurrent;
+    }
+    return total;
+}
+
+std::vector<OllamaBackendStats> OllamaLoadBalancer::GetStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<OllamaBackendStats> stats;
+    stats.reserve(m_backends.size());
+    for (const auto& backend : m_backends)
+    {
+        stats.push_back({ backend->endpoint->url, backend->weight, backend->maxConcurrent, backend->outstanding,
+                          backend->down, backend->latencyEwmaMs, backend->requests, backend->failures });
+    }
+    return stats;
+}
@@ -0,0 +1,92 @@
+#ifndef MOD_OLLAMA_CHAT_LOADBALANCER_H
+#define MOD_OLLAMA_CHAT_LOADBALANCER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct OllamaEndpoint;
+
+// One Ollama server in the rotation. Runtime fields are guarded by the
+// balancer's mutex; the endpoint itself is immutable.
+struct OllamaBackend
+{
+    std::shared_ptr<const OllamaEndpoint> endpoint;
+    std::shared_ptr<const OllamaEndpoint> chatEndpoint; // same server, /api/chat
+    uint32_t weight = 1;
+    uint32_t maxConcurrent = 0; // 0 means no cap
+
+    uint32_t outstanding = 0;
+    uint32_t consecutiveFailures = 0;
+    bool down = false;
+    bool probing = false; // a trial request is in flight while down
+    std::chrono::steady_clock::time_point retryAt;
+    double latencyEwmaMs = 0.0;
+    uint64_t requests = 0;
+    uint64_t failures = 0;
+};
+
+// Read-only copy of a backend's state for reporting.
+struct OllamaBackendStats
+{
+    std::string url;
+    uint32_t weight;
+    uint32_t maxConcurrent;
+    uint32_t outstanding;
+    bool down;
+    double latencyEwmaMs;
+    uint64_t requests;
+    uint64_t failures;
+};
+
+enum class BackendSelection
+{
+    LeastOutstanding,
+    LatencyEwma
+};
+
+// Spreads LLM requests over several Ollama servers. Backends that keep
+// failing are taken out of rotation and probed back in after a delay.
+class OllamaLoadBalancer
+{
+public:
+    // Replace the backend list (called on config load). In-flight requests keep
+    // their old backend alive until they release it.
+    void Configure(std::vector<std::shared_ptr<OllamaBackend>> backends, BackendSelection selection,
+                   uint32_t failureThreshold, uint32_t retryIntervalSeconds);
+
+    // Pick a backend for a new request, or nullptr if every backend is down.
+    // While every healthy backend is at its maxConcurrent cap this blocks until
+    // a request is released or a down backend is due for a retry, so a cap is
+    // never exceeded. Gives up and returns nullptr after maxWait.
+    std::shared_ptr<OllamaBackend> Acquire(std::chrono::seconds maxWait);
+    // Report the result of a request made with a backend from Acquire().
+    void Release(const std::shared_ptr<OllamaBackend>& backend, bool success, uint64_t latencyMs);
+    // Wake every caller waiting in Acquire() and make it return nullptr from now on.
+    void Shutdown();
+
+    // Sum of the backends' concurrency caps, or 0 if any backend is uncapped.
+    uint32_t GetTotalCapacity();
+    std::vector<OllamaBackendStats> GetStats();
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_capacityFreed;
+    bool m_stopping = false;
+    std::vector<std::shared_ptr<OllamaBackend>> m_backends;
+    BackendSelection m_selection = BackendSelection::LeastOutstanding;
+    uint32_t m_failureThreshold = 3;
+    std::chrono::seconds m_retryInterval{30};
+};
+
+// Parse "url|weight|maxConcurrent" entries separated by commas. Weight and
+// maxConcurrent are optional. Invalid entries are logged and skipped.
+std::vector<std::shared_ptr<OllamaBackend>> ParseOllamaBackends(const std::string& backendList);
+
+extern OllamaLoadBalancer g_LoadBalancer;
+
+#endif // MOD_OLLAMA_CHAT_LOADBALANCER_H
@@ -4,6 +4,8 @@
 #include "mod-ollama-chat_events.h"
 #include "mod-ollama-chat_command.h"
 #include "mod-ollama-chat_rag.h"
+#include "mod-ollama-chat_presence.h"
+#include "mod-ollama-chat_outbox.h"
 #include "Log.h"
 
 void Addmod_ollama_chatScripts()
@@ -12,6 +14,10 @@ void Addmod_ollama_chatScripts()
     new OllamaChatConfigWorldScript();
     new PlayerBotChatHandler();
     new OllamaBotRandomChatter();
+    new OllamaPresenceTracker();
+    new OllamaPresenceGuildTracker();
+    new OllamaReplyDelivery();
+    new OllamaSnapshotCacheTracker();
 
     LOG_INFO("server.loading", "[Ollama Chat] Registering mod-ollama-chat events.");
     new ChatOnKill();
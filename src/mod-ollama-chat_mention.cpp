@@ -0,0 +1,114 @@
+#include "mod-ollama-chat_mention.h"
+#include <algorithm>
+#include <cctype>
+#include <queue>
+
+static unsigned char ToLowerByte(char c)
+{
+    return static_cast<unsigned char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
+MentionMatcher::MentionMatcher() : m_nodes(1) {}
+
+int MentionMatcher::Child(int node, unsigned char c) const
+{
+    for (const auto& [label, child] : m_nodes[node].next)
+    {
+        if (label == c)
+            return child;
+    }
+    return -1;
+}
+
+void MentionMatcher::Add(const std::string& name, size_t id)
+{
+    if (name.empty())
+        return;
+
+    int node = 0;
+    for (char ch : name)
+    {
+        unsigned char c = ToLowerByte(ch);
+        int child = Child(node, c);
+        if (child < 0)
+        {
+            child = static_cast<int>(m_nodes.size());
+            m_nodes[node].next.emplace_back(c, child);
+            m_nodes.emplace_back();
+        }
+        node = child;
+    }
+
+    // Names that only differ in case are the same name; the first one wins
+    if (m_nodes[node].pattern < 0)
+    {
+        m_nodes[node].pattern = static_cast<int>(m_patterns.size());
+        m_patterns.push_back({ name.size(), id });
+    }
+}
+
+void MentionMatcher::Build()
+{
+    std::queue<int> pending;
+    for (const auto& [label, child] : m_nodes[0].next)
+    {
+        m_nodes[child].fail = 0;
+        m_nodes[child].dictLink = -1;
+        pending.push(child);
+    }
+
+    while (!pending.empty())
+    {
+        int node = pending.front();
+        pending.pop();
+
+        for (const auto& [label, child] : m_nodes[node].next)
+        {
+            int fail = m_nodes[node].fail;
+            int target = Child(fail, label);
+            while (fail != 0 && target < 0)
+            {
+                fail = m_nodes[fail].fail;
+                target = Child(fail, label);
+            }
+            m_nodes[child].fail = (target >= 0 && target != child) ? target : 0;
+
+            const Node& failNode = m_nodes[m_nodes[child].fail];
+            m_nodes[child].dictLink = failNode.pattern >= 0 ? m_nodes[child].fail : failNode.dictLink;
+            pending.push(child);
+        }
+    }
+}
+
+std::vector<std::pair<size_t, size_t>> MentionMatcher::FindAll(const std::string& text) const
+{
+    std::vector<std::pair<size_t, size_t>> matches;
+    auto isWordChar = [&text](size_t pos) {
+        return std::isalnum(static_cast<unsigned char>(text[pos])) != 0;
+    };
+
+    int state = 0;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        unsigned char c = ToLowerByte(text[i]);
+        int next = Child(state, c);
+        while (state != 0 && next < 0)
+        {
+            state = m_nodes[state].fail;
+            next = Child(state, c);
+        }
+        state = next < 0 ? 0 : next;
+
+        for (int node = m_nodes[state].pattern >= 0 ? state : m_nodes[state].dictLink; node > 0; node = m_nodes[node].dictLink)
+        {
+            const Pattern& pattern = m_patterns[m_nodes[node].pattern];
+            size_t start = i + 1 - pattern.length;
+            size_t end = i + 1;
+            if ((start == 0 || !isWordChar(start - 1)) && (end >= text.size() || !isWordChar(end)))
+                matches.emplace_back(start, pattern.id);
+        }
+    }
+
+    std::sort(matches.begin(), matches.end());
+    return matches;
+}
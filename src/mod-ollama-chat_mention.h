@@ -0,0 +1,46 @@
+#ifndef MOD_OLLAMA_CHAT_MENTION_H
+#define MOD_OLLAMA_CHAT_MENTION_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Finds which of a set of names are mentioned in a message. The names are
+// compiled into one Aho-Corasick automaton, so the message is lowercased and
+// scanned once no matter how many names there are. Matching is ASCII
+// case-insensitive, and a match only counts if it is a whole word.
+class MentionMatcher
+{
+public:
+    MentionMatcher();
+
+    // Add a name; id is reported back with its matches. Call Build() before FindAll().
+    void Add(const std::string& name, size_t id);
+    void Build();
+
+    // Every whole-word mention in text as (position, id), ordered by position.
+    std::vector<std::pair<size_t, size_t>> FindAll(const std::string& text) const;
+
+private:
+    struct Node
+    {
+        std::vector<std::pair<unsigned char, int>> next;
+        int fail = 0;
+        int dictLink = -1;  // nearest node on the fail chain that ends a name
+        int pattern = -1;   // index into m_patterns of the name ending here
+    };
+
+    struct Pattern
+    {
+        size_t length;
+        size_t id;
+    };
+
+    int Child(int node, unsigned char c) const;
+
+    std::vector<Node> m_nodes;
+    std::vector<Pattern> m_patterns;
+};
+
+#endif // MOD_OLLAMA_CHAT_MENTION_H
@@ -0,0 +1,103 @@
+#include "mod-ollama-chat_outbox.h"
+#include "mod-ollama-chat_config.h"
+#include "Log.h"
+#include "ObjectAccessor.h"
+#include "Player.h"
+#include <algorithm>
+
+OllamaReplyOutbox g_ReplyOutbox;
+
+std::chrono::milliseconds GetTypingDelay(size_t length)
+{
+    if (!g_EnableTypingSimulation)
+        return std::chrono::milliseconds(0);
+    return std::chrono::milliseconds(g_TypingSimulationBaseDelay + uint64_t(length) * g_TypingSimulationDelayPerChar);
+}
+
+static bool DueLater(const OllamaReply& a, const OllamaReply& b)
+{
+    return a.notBefore > b.notBefore;
+}
+
+OllamaReplyOutbox::~OllamaReplyOutbox()
+{
+    Node* node = m_head.exchange(nullptr, std::memory_order_acquire);
+    while (node)
+    {
+        Node* next = node->next;
+        delete node;
+        node = next;
+    }
+}
+
+void OllamaReplyOutbox::Push(OllamaReply reply)
+{
+    Node* node = new Node{ std::move(reply), m_head.load(std::memory_order_relaxed) };
+    while (!m_head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+}
+
+size_t OllamaReplyOutbox::Drain(size_t budget)
+{
+    auto now = std::chrono::steady_clock::now();
+
+    // The stack is newest first; reverse it so replies go out in the order they finished
+    Node* node = m_head.exchange(nullptr, std::memory_order_acquire);
+    Node* ordered = nullptr;
+    while (node)
+    {
+        Node* next = node->next;
+        node->next = ordered;
+        ordered = node;
+        node = next;
+    }
+    while (ordered)
+    {
+        Node* next = ordered->next;
+        if (ordered->reply.notBefore > now)
+        {
+            m_typing.push_back(std::move(ordered->reply));
+            std::push_heap(m_typing.begin(), m_typing.end(), DueLater);
+        }
+        else
+        {
+            m_ready.push_back(std::move(ordered->reply));
+        }
+        delete ordered;
+        ordered = next;
+    }
+
+    while (!m_typing.empty() && m_typing.front().notBefore <= now)
+    {
+        std::pop_heap(m_typing.begin(), m_typing.end(), DueLater);
+        m_ready.push_back(std::move(m_typing.back()));
+        m_typing.pop_back();
+    }
+
+    size_t delivered = 0;
+    while (!m_ready.empty() && (budget == 0 || delivered < budget))
+    {
+        OllamaReply reply = std::move(m_ready.front());
+        m_ready.pop_front();
+        ++delivered;
+
+        Player* bot = ObjectAccessor::FindPlayer(ObjectGuid(reply.botGuid));
+        if (!bot || !reply.deliver)
+        {
+            if (g_DebugEnabled)
+                LOG_INFO("server.loading", "[Ollama Chat] Dropping reply for bot GUID {} (bot is offline)", reply.botGuid);
+            continue;
+        }
+        reply.deliver(bot, reply);
+    }
+    return delivered;
+}
+
+OllamaReplyDelivery::OllamaReplyDelivery() : WorldScript("OllamaReplyDelivery") {}
+
+void OllamaReplyDelivery::OnUpdate(uint32 /*diff*/)
+{
+    // Drain even when the module was just disabled, so nothing is left queued
+    g_ReplyOutbox.Drain(g_MaxRepliesPerTick);
+}
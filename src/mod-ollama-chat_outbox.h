@@ -0,0 +1,77 @@
+#ifndef MOD_OLLAMA_CHAT_OUTBOX_H
+#define MOD_OLLAMA_CHAT_OUTBOX_H
+
+#include "ScriptMgr.h"
+#include "mod-ollama-chat_handler.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+struct OllamaReply;
+
+// Sends a reply for a bot that is online; runs on the world thread.
+using OllamaReplyHandler = void (*)(Player* bot, const OllamaReply& reply);
+
+// A finished LLM reply waiting to be said by a bot.
+struct OllamaReply
+{
+    OllamaReplyHandler deliver = nullptr;
+    uint64_t botGuid = 0;
+    uint64_t senderGuid = 0;                         // player being answered, 0 for chatter
+    ChatChannelSourceLocal sourceLocal = SRC_UNDEFINED_LOCAL;
+    uint32_t channelId = 0;
+    std::string channelName;
+    std::string text;
+    std::string playerMessage;                       // message being answered, for history and sentiment
+    bool guild = false;                              // chatter meant for guild chat
+    bool sent = false;                               // text already went out sentence by sentence
+    std::chrono::steady_clock::time_point notBefore; // typing simulation: hold until then
+};
+
+// How long a bot "types" a reply of this length; zero when typing simulation is off.
+std::chrono::milliseconds GetTypingDelay(size_t length);
+
+// Reply threads push finished replies here instead of looking up the bot and
+// talking through it themselves; the world thread drains them during its
+// update, where touching Player is safe. Push is lock-free: producers CAS onto
+// a singly linked stack, and the single consumer takes the whole stack at once
+// and reverses it back into arrival order. Replies still "being typed" wait in
+// a min-heap on their due time, so a typing bot costs only its reply payload.
+class OllamaReplyOutbox
+{
+public:
+    ~OllamaReplyOutbox();
+
+    // Any thread.
+    void Push(OllamaReply reply);
+
+    // World thread only. Delivers at most budget due replies (0 for all) and
+    // keeps the rest for the next call. Returns the number delivered.
+    size_t Drain(size_t budget);
+
+private:
+    struct Node
+    {
+        OllamaReply reply;
+        Node* next = nullptr;
+    };
+
+    std::atomic<Node*> m_head{ nullptr };
+    // Owned by the consumer
+    std::deque<OllamaReply> m_ready;
+    std::vector<OllamaReply> m_typing; // min-heap on notBefore
+};
+
+extern OllamaReplyOutbox g_ReplyOutbox;
+
+class OllamaReplyDelivery : public WorldScript
+{
+public:
+    OllamaReplyDelivery();
+    void OnUpdate(uint32 diff) override;
+};
+
+#endif // MOD_OLLAMA_CHAT_OUTBOX_H
@@ -0,0 +1,277 @@
+#include "mod-ollama-chat_presence.h"
+#include "Guild.h"
+#include "ObjectAccessor.h"
+#include "PlayerbotAI.h"
+#include "PlayerbotMgr.h"
+#include <shared_mutex>
+
+OllamaPresenceIndex g_PresenceIndex;
+
+static std::shared_mutex s_BotFlagsMutex;
+static std::vector<uint64_t> s_BotFlags; // one bit per player GUID counter
+
+static bool IsCachedBot(uint32_t counter)
+{
+    std::shared_lock<std::shared_mutex> lock(s_BotFlagsMutex);
+    size_t word = counter / 64;
+    return word < s_BotFlags.size() && (s_BotFlags[word] >> (counter % 64)) & 1;
+}
+
+PlayerKind GetPlayerKind(Player* player)
+{
+    if (!player)
+        return PlayerKind::RealPlayer;
+
+    uint32_t counter = player->GetGUID().GetCounter();
+    if (IsCachedBot(counter))
+        return PlayerKind::Bot;
+
+    PlayerbotAI* ai = PlayerbotsMgr::instance().GetPlayerbotAI(player);
+    if (!ai)
+        return PlayerKind::RealPlayer;
+    if (!ai->IsBotAI())
+        return PlayerKind::RealPlayerWithAI;
+
+    // A bot stays a bot until it logs out
+    std::unique_lock<std::shared_mutex> lock(s_BotFlagsMutex);
+    size_t word = counter / 64;
+    if (word >= s_BotFlags.size())
+        s_BotFlags.resize(word + 1, 0);
+    s_BotFlags[word] |= uint64_t(1) << (counter % 64);
+    return PlayerKind::Bot;
+}
+
+bool IsBotPlayer(Player* player)
+{
+    return GetPlayerKind(player) == PlayerKind::Bot;
+}
+
+bool HasPlayerbotAI(Player* player)
+{
+    return GetPlayerKind(player) != PlayerKind::RealPlayer;
+}
+
+void ForgetPlayerKind(Player* player)
+{
+    if (!player)
+        return;
+
+    uint32_t counter = player->GetGUID().GetCounter();
+    std::unique_lock<std::shared_mutex> lock(s_BotFlagsMutex);
+    size_t word = counter / 64;
+    if (word < s_BotFlags.size())
+        s_BotFlags[word] &= ~(uint64_t(1) << (counter % 64));
+}
+
+void OllamaPresenceIndex::Insert(uint64_t guid, const Entry& entry)
+{
+    auto addTo = [&](Bucket& bucket) {
+        (entry.isBot ? bucket.bots : bucket.realPlayers).insert(guid);
+    };
+    addTo(m_all);
+    addTo(m_byZone[entry.zoneId]);
+    if (entry.guildId != 0)
+        addTo(m_byGuild[entry.guildId]);
+    m_entries[guid] = entry;
+}
+
+void OllamaPresenceIndex::Erase(uint64_t guid)
+{
+    auto it = m_entries.find(guid);
+    if (it == m_entries.end())
+        return;
+
+    const Entry& entry = it->second;
+    auto removeFrom = [&](std::unordered_map<uint32_t, Bucket>& buckets, uint32_t key) {
+        auto bucket = buckets.find(key);
+        if (bucket == buckets.end())
+            return;
+        (entry.isBot ? bucket->second.bots : bucket->second.realPlayers).erase(guid);
+        if (bucket->second.bots.empty() && bucket->second.realPlayers.empty())
+            buckets.erase(bucket);
+    };
+    (entry.isBot ? m_all.bots : m_all.realPlayers).erase(guid);
+    removeFrom(m_byZone, entry.zoneId);
+    if (entry.guildId != 0)
+        removeFrom(m_byGuild, entry.guildId);
+    m_entries.erase(it);
+}
+
+void OllamaPresenceIndex::Store(uint64_t guid, const Entry& entry)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Erase(guid);
+    Insert(guid, entry);
+}
+
+void OllamaPresenceIndex::Add(Player* player)
+{
+    if (!player)
+        return;
+
+    Entry entry;
+    entry.zoneId = player->GetZoneId();
+    entry.guildId = player->GetGuildId();
+    entry.isBot = IsBotPlayer(player);
+    Store(player->GetGUID().GetRawValue(), entry);
+}
+
+void OllamaPresenceIndex::Remove(Player* player)
+{
+    if (!player)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Erase(player->GetGUID().GetRawValue());
+}
+
+void OllamaPresenceIndex::UpdateZone(Player* player, uint32_t zoneId)
+{
+    if (!player)
+        return;
+
+    Entry entry;
+    entry.zoneId = zoneId;
+    entry.guildId = player->GetGuildId();
+    entry.isBot = IsBotPlayer(player);
+    Store(player->GetGUID().GetRawValue(), entry);
+}
+
+void OllamaPresenceIndex::UpdateGuild(Player* player, uint32_t guildId)
+{
+    if (!player)
+        return;
+
+    Entry entry;
+    entry.zoneId = player->GetZoneId();
+    entry.guildId = guildId;
+    entry.isBot = IsBotPlayer(player);
+    Store(player->GetGUID().GetRawValue(), entry);
+}
+
+std::vector<Player*> OllamaPresenceIndex::Collect(Scope scope, uint32_t key, bool bots, bool stopAtFirst)
+{
+    std::vector<std::pair<uint64_t, bool>> guids; // guid, filed as a bot
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const Bucket* bucket = &m_all;
+        if (scope != Scope::All)
+        {
+            auto& buckets = scope == Scope::Zone ? m_byZone : m_byGuild;
+            auto it = buckets.find(key);
+            if (it == buckets.end())
+                return {};
+            bucket = &it->second;
+        }
+        // A bot can still sit among the real players if its AI was attached
+        // after it was indexed, so bot lookups check both
+        for (uint64_t guid : bucket->realPlayers)
+            guids.emplace_back(guid, false);
+        if (bots)
+        {
+            for (uint64_t guid : bucket->bots)
+                guids.emplace_back(guid, true);
+        }
+    }
+
+    std::vector<Player*> players;
+    players.reserve(guids.size());
+    for (const auto& [guid, filedAsBot] : guids)
+    {
+        Player* player = ObjectAccessor::FindConnectedPlayer(ObjectGuid(guid));
+        if (!player)
+        {
+            // Logged out without the hook firing
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Erase(guid);
+            continue;
+        }
+
+        // The bot AI can be attached after login, and zone or guild changes can
+        // be missed; re-index the player from its live state. A player that
+        // turns out to be a bot still counts for a bot lookup in the same scope.
+        bool isBot = IsBotPlayer(player);
+        bool inScope = (scope != Scope::Zone || player->GetZoneId() == key) &&
+                       (scope != Scope::Guild || player->GetGuildId() == key);
+        if (!inScope || isBot != filedAsBot)
+            Add(player);
+        if (!inScope || isBot != bots)
+            continue;
+
+        players.push_back(player);
+        if (stopAtFirst)
+            break;
+    }
+    return players;
+}
+
+std::vector<Player*> OllamaPresenceIndex::GetBots()
+{
+    return Collect(Scope::All, 0, true);
+}
+
+std::vector<Player*> OllamaPresenceIndex::GetBotsInZone(uint32_t zoneId)
+{
+    return Collect(Scope::Zone, zoneId, true);
+}
+
+std::vector<Player*> OllamaPresenceIndex::GetBotsInGuild(uint32_t guildId)
+{
+    if (guildId == 0)
+        return {};
+    return Collect(Scope::Guild, guildId, true);
+}
+
+std::vector<Player*> OllamaPresenceIndex::GetRealPlayers()
+{
+    return Collect(Scope::All, 0, false);
+}
+
+std::vector<Player*> OllamaPresenceIndex::GetRealPlayersInZone(uint32_t zoneId)
+{
+    return Collect(Scope::Zone, zoneId, false);
+}
+
+bool OllamaPresenceIndex::HasRealPlayerInGuild(uint32_t guildId)
+{
+    if (guildId == 0)
+        return false;
+    return !Collect(Scope::Guild, guildId, false, true).empty();
+}
+
+bool OllamaPresenceIndex::IsOnline(uint64_t guid)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.count(guid) != 0;
+}
+
+OllamaPresenceTracker::OllamaPresenceTracker() : PlayerScript("OllamaPresenceTracker") {}
+
+void OllamaPresenceTracker::OnPlayerLogin(Player* player)
+{
+    g_PresenceIndex.Add(player);
+}
+
+void OllamaPresenceTracker::OnPlayerLogout(Player* player)
+{
+    g_PresenceIndex.Remove(player);
+    ForgetPlayerKind(player);
+}
+
+void OllamaPresenceTracker::OnPlayerUpdateZone(Player* player, uint32 newZone, uint32 /*newArea*/)
+{
+    g_PresenceIndex.UpdateZone(player, newZone);
+}
+
+OllamaPresenceGuildTracker::OllamaPresenceGuildTracker() : GuildScript("OllamaPresenceGuildTracker") {}
+
+void OllamaPresenceGuildTracker::OnAddMember(Guild* guild, Player* player, uint8& /*plRank*/)
+{
+    if (guild)
+        g_PresenceIndex.UpdateGuild(player, guild->GetId());
+}
+
+void OllamaPresenceGuildTracker::OnRemoveMember(Guild* /*guild*/, Player* player, bool /*isDisbanding*/, bool /*isKicked*/)
+{
+    g_PresenceIndex.UpdateGuild(player, 0);
+}
@@ -0,0 +1,109 @@
+#ifndef MOD_OLLAMA_CHAT_PRESENCE_H
+#define MOD_OLLAMA_CHAT_PRESENCE_H
+
+#include "ScriptMgr.h"
+#include "Player.h"
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// How a character is controlled, as far as the module is concerned.
+enum class PlayerKind : uint8_t
+{
+    RealPlayer,       // no playerbot AI
+    RealPlayerWithAI, // real player with a playerbot AI attached (self-bot)
+    Bot
+};
+
+// Bots are remembered in a bitset indexed by GUID counter until they log out,
+// so repeated checks skip the PlayerbotsMgr lookup. A player without a bot AI
+// is never cached as a real player, because the AI can be attached after login.
+PlayerKind GetPlayerKind(Player* player);
+bool IsBotPlayer(Player* player);
+// True for bots and for real players with a playerbot AI attached.
+bool HasPlayerbotAI(Player* player);
+void ForgetPlayerKind(Player* player);
+
+// Online bots and real players bucketed by zone and guild, so chat eligibility
+// only looks at the players in scope instead of scanning every online player.
+// Kept up to date by the login/logout/zone/guild hooks below. Lookups re-check
+// each entry against the live player and re-index it if a hook was missed.
+//
+// The playerbot AI is attached after OnPlayerLogin, so a bot is usually filed
+// as a real player at first. Being a bot is therefore decided at lookup time:
+// the bot bucket only holds confirmed bots, and bot lookups also check the
+// real player bucket, moving any bot they find there.
+class OllamaPresenceIndex
+{
+public:
+    // Insert or re-index a player from its current zone, guild and bot state.
+    void Add(Player* player);
+    void Remove(Player* player);
+    void UpdateZone(Player* player, uint32_t zoneId);
+    void UpdateGuild(Player* player, uint32_t guildId);
+
+    std::vector<Player*> GetBots();
+    std::vector<Player*> GetBotsInZone(uint32_t zoneId);
+    std::vector<Player*> GetBotsInGuild(uint32_t guildId);
+    std::vector<Player*> GetRealPlayers();
+    std::vector<Player*> GetRealPlayersInZone(uint32_t zoneId);
+    bool HasRealPlayerInGuild(uint32_t guildId);
+    // Only reads the index, so it is safe off the world thread.
+    bool IsOnline(uint64_t guid);
+
+private:
+    struct Entry
+    {
+        uint32_t zoneId = 0;
+        uint32_t guildId = 0;
+        bool isBot = false;
+    };
+
+    struct Bucket
+    {
+        std::unordered_set<uint64_t> bots;        // confirmed bots
+        std::unordered_set<uint64_t> realPlayers; // not seen with a bot AI yet
+    };
+
+    enum class Scope
+    {
+        All,
+        Zone,
+        Guild
+    };
+
+    void Insert(uint64_t guid, const Entry& entry); // requires m_mutex held
+    void Erase(uint64_t guid);                      // requires m_mutex held
+    void Store(uint64_t guid, const Entry& entry);
+    // Players of one kind in a bucket, verified against their live state.
+    std::vector<Player*> Collect(Scope scope, uint32_t key, bool bots, bool stopAtFirst = false);
+
+    std::mutex m_mutex;
+    std::unordered_map<uint64_t, Entry> m_entries;
+    Bucket m_all;
+    std::unordered_map<uint32_t, Bucket> m_byZone;
+    std::unordered_map<uint32_t, Bucket> m_byGuild; // guild 0 (no guild) is not indexed
+};
+
+extern OllamaPresenceIndex g_PresenceIndex;
+
+class OllamaPresenceTracker : public PlayerScript
+{
+public:
+    OllamaPresenceTracker();
+    void OnPlayerLogin(Player* player) override;
+    void OnPlayerLogout(Player* player) override;
+    void OnPlayerUpdateZone(Player* player, uint32 newZone, uint32 newArea) override;
+};
+
+class OllamaPresenceGuildTracker : public GuildScript
+{
+public:
+    OllamaPresenceGuildTracker();
+    void OnAddMember(Guild* guild, Player* player, uint8& plRank) override;
+    void OnRemoveMember(Guild* guild, Player* player, bool isDisbanding, bool isKicked) override;
+};
+
+#endif // MOD_OLLAMA_CHAT_PRESENCE_H
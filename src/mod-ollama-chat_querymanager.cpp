@@ -1,56 +1,346 @@
 #include "mod-ollama-chat_querymanager.h"
-#include "mod-ollama-chat_config.h"  // For g_MaxConcurrentQueries
-#include <thread>
+#include "mod-ollama-chat_config.h"  // For g_MaxConcurrentQueries, g_MaxQueuedQueries
+#include "Log.h"
+#include <algorithm>
 
-// Constructor: initialize with the configuration value.
+const char* QueryPriorityName(QueryPriority priority)
+{
+    switch (priority)
+    {
+        case QueryPriority::Whisper:    return "Whisper";
+        case QueryPriority::Mention:    return "Mention";
+        case QueryPriority::PartyGuild: return "PartyGuild";
+        case QueryPriority::Event:      return "Event";
+        case QueryPriority::Ambient:    return "Ambient";
+        case QueryPriority::Background: return "Background";
+        default:                        return "Unknown";
+    }
+}
+
+const char* QueryPurposeName(QueryPurpose purpose)
+{
+    switch (purpose)
+    {
+        case QueryPurpose::Conversation: return "Conversation";
+        case QueryPurpose::Event:        return "Event";
+        case QueryPurpose::Random:       return "Random";
+        case QueryPurpose::Sentiment:    return "Sentiment";
+        case QueryPurpose::Guild:        return "Guild";
+        default:                         return "Unknown";
+    }
+}
+
+// Constructor: initialize with the configuration values. Workers are started
+// on the first submitted query so no threads exist before the config is loaded.
 QueryManager::QueryManager()
-    : maxConcurrentQueries(g_MaxConcurrentQueries), currentQueries(0)
+    : maxConcurrentQueries(g_MaxConcurrentQueries), maxQueueSize(g_MaxQueuedQueries),
+      backendCapacity(0), runningQueries(0), stopping(false), weightedScheduling(false),
+      classWeights{ 32, 16, 8, 4, 2, 1 }, classCredits{}, classStats{}
 {
 }
 
-// Set maximum concurrent queries (0 means no limit).
+QueryManager::~QueryManager()
+{
+    shutdown();
+}
+
+// Number of workers the pool should have for the current limit.
+size_t QueryManager::desiredWorkerCount() const
+{
+    if (maxConcurrentQueries > 0)
+        return static_cast<size_t>(maxConcurrentQueries);
+    if (backendCapacity > 0)
+        return backendCapacity;
+
+    unsigned int hw = std::thread::hardware_concurrency();
+    return std::max<size_t>(2, hw);
+}
+
+size_t QueryManager::queuedCount() const
+{
+    size_t total = 0;
+    for (const auto& queue : taskQueues)
+    {
+        total += queue.size();
+    }
+    return total;
+}
+
+// Grow the pool up to the desired size. Shrinking is handled by workers
+// honouring the concurrency limit, so existing threads are never torn down here.
+void QueryManager::startWorkers()
+{
+    if (stopping)
+        return;
+
+    size_t desired = desiredWorkerCount();
+    while (workers.size() < desired)
+    {
+        workers.emplace_back(&QueryManager::workerLoop, this);
+    }
+}
+
+// Set maximum concurrent queries (0 means one worker per hardware thread).
 void QueryManager::setMaxConcurrentQueries(int maxQueries) {
     std::lock_guard<std::mutex> lock(mutex_);
-    maxConcurrentQueries = maxQueries;
+    maxConcurrentQueries = std::max(0, maxQueries);
+    if (!workers.empty())
+        startWorkers();
+    condition_.notify_all();
+}
+
+void QueryManager::setBackendCapacity(uint32_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    backendCapacity = capacity;
+    if (!workers.empty())
+        startWorkers();
+    condition_.notify_all();
 }
 
-// Submit a query and return a future for the result.
-std::future<std::string> QueryManager::submitQuery(const std::string& prompt) {
-    std::promise<std::string> promise;
-    std::future<std::string> future = promise.get_future();
+// Set the maximum number of waiting queries (0 means no limit).
+void QueryManager::setMaxQueueSize(int maxQueued) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    maxQueueSize = std::max(0, maxQueued);
+}
 
-    bool shouldRunNow = false;
+void QueryManager::setWeightedScheduling(bool weighted) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    weightedScheduling = weighted;
+    classCredits.fill(0);
+}
 
+// Missing or zero weights are treated as 1 so no class can starve completely.
+void QueryManager::setPriorityWeights(const std::vector<uint32_t>& weights) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < QUERY_PRIORITY_COUNT; ++i)
+    {
+        classWeights[i] = (i < weights.size() && weights[i] > 0) ? weights[i] : 1;
+    }
+    classCredits.fill(0);
+}
+
+std::array<QueryClassStats, QUERY_PRIORITY_COUNT> QueryManager::getStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return classStats;
+}
+
+// Submit a query and return a future for the result. When the queue is full the
+// newest task of a lower priority class is shed to make room; if there is none,
+// or the manager is shutting down, the future resolves to an empty string.
+std::future<std::string> QueryManager::submitQuery(const std::string& prompt, QueryPriority priority, QueryPurpose purpose) {
+    OllamaRequest request;
+    request.prompt = prompt;
+    request.purpose = purpose;
+    return submitQuery(std::move(request), priority);
+}
+
+std::future<std::string> QueryManager::submitQuery(OllamaRequest request, QueryPriority priority,
+                                                   std::function<bool(const std::string&)> onSentence) {
+    auto promise = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> future = promise->get_future();
+    submitQueryAsync(std::move(request), priority,
+                     [promise](std::string result) { promise->set_value(std::move(result)); },
+                     std::move(onSentence));
+    return future;
+}
+
+// Submit a query whose reply goes to onComplete. When the queue is full the
+// newest task of a lower priority class is shed to make room; if there is none,
+// or the manager is shutting down, onComplete gets an empty string right away.
+void QueryManager::submitQueryAsync(OllamaRequest request, QueryPriority priority, QueryCompleteFn onComplete,
+                                    QuerySentenceFn onSentence, QueryPrepareFn prepare) {
+    size_t cls = std::min(static_cast<size_t>(priority), QUERY_PRIORITY_COUNT - 1);
+    QueryTask task{ std::move(request), std::chrono::steady_clock::now(), std::move(onComplete),
+                    std::move(onSentence), std::move(prepare) };
+
+    // Completions of rejected tasks run after the lock is released, since they
+    // may submit follow-up queries
+    QueryCompleteFn rejected;
+    QueryCompleteFn shed;
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        if (maxConcurrentQueries == 0 || currentQueries < maxConcurrentQueries) {
-            ++currentQueries;
-            shouldRunNow = true;
-        } else {
-            taskQueue.push({ prompt, std::move(promise) });
+        if (stopping)
+        {
+            rejected = std::move(task.onComplete);
+        }
+        else if (maxQueueSize > 0 && queuedCount() >= static_cast<size_t>(maxQueueSize))
+        {
+            size_t victim = QUERY_PRIORITY_COUNT;
+            for (size_t i = QUERY_PRIORITY_COUNT; i-- > cls + 1;)
+            {
+                if (!taskQueues[i].empty())
+                {
+                    victim = i;
+                    break;
+                }
+            }
+
+            if (victim == QUERY_PRIORITY_COUNT)
+            {
+                ++classStats[cls].dropped;
+                if (g_DebugEnabled)
+                {
+                    LOG_INFO("server.loading", "[Ollama Chat] Query queue full, dropping {} query.", QueryPriorityName(priority));
+                }
+                rejected = std::move(task.onComplete);
+            }
+            else
+            {
+                shed = std::move(taskQueues[victim].back().onComplete);
+                taskQueues[victim].pop_back();
+                --classStats[victim].queued;
+                ++classStats[victim].dropped;
+                if (g_DebugEnabled)
+                {
+                    LOG_INFO("server.loading", "[Ollama Chat] Query queue full, shed {} query for {} query.",
+                             QueryPriorityName(static_cast<QueryPriority>(victim)), QueryPriorityName(priority));
+                }
+            }
+        }
+
+        if (!rejected)
+        {
+            startWorkers();
+            taskQueues[cls].push_back(std::move(task));
+            QueryClassStats& stats = classStats[cls];
+            ++stats.submitted;
+            ++stats.queued;
+            stats.peakQueued = std::max(stats.peakQueued, stats.queued);
         }
     }
 
-    if (shouldRunNow) {
-        std::thread(&QueryManager::processQuery, this, prompt, std::move(promise)).detach();
+    if (rejected)
+    {
+        rejected("");
+        return;
     }
+    if (shed)
+        shed("");
+    condition_.notify_one();
+}
 
-    return future;
+// Choose the class to serve next. Strict mode always takes the highest
+// non-empty class; weighted mode uses smooth weighted round-robin over the
+// non-empty classes so lower classes still make progress under load.
+size_t QueryManager::pickNextClass()
+{
+    if (!weightedScheduling)
+    {
+        for (size_t i = 0; i < QUERY_PRIORITY_COUNT; ++i)
+        {
+            if (!taskQueues[i].empty())
+                return i;
+        }
+        return 0;
+    }
+
+    int64_t totalWeight = 0;
+    size_t best = QUERY_PRIORITY_COUNT;
+    for (size_t i = 0; i < QUERY_PRIORITY_COUNT; ++i)
+    {
+        if (taskQueues[i].empty())
+            continue;
+        classCredits[i] += classWeights[i];
+        totalWeight += classWeights[i];
+        if (best == QUERY_PRIORITY_COUNT || classCredits[i] > classCredits[best])
+            best = i;
+    }
+    classCredits[best] -= totalWeight;
+    return best;
 }
 
-// Process the query by calling the API and then handling any queued tasks.
-void QueryManager::processQuery(const std::string& prompt, std::promise<std::string> promise) {
-    std::string result = QueryOllamaAPI(prompt);
-    promise.set_value(result);
+// Worker thread: take the next task whenever the concurrency limit allows it.
+void QueryManager::workerLoop() {
+    for (;;)
+    {
+        QueryTask task;
+        size_t cls;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this] {
+                return stopping || (queuedCount() > 0 && runningQueries < desiredWorkerCount());
+            });
+            if (stopping)
+                return;
+
+            cls = pickNextClass();
+            task = std::move(taskQueues[cls].front());
+            taskQueues[cls].pop_front();
+            --classStats[cls].queued;
+            ++classStats[cls].inFlight;
+            ++runningQueries;
+        }
+
+        std::string result;
+        try
+        {
+            if (!task.prepare || task.prepare(task.request))
+            {
+                result = task.onSentence ? QueryOllamaAPIStreaming(task.request, task.onSentence)
+                                         : QueryOllamaAPI(task.request);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR("server.loading", "[Ollama Chat] Query worker caught exception: {}", e.what());
+        }
+        bool succeeded = !result.empty();
+        try
+        {
+            task.onComplete(std::move(result));
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR("server.loading", "[Ollama Chat] Query completion caught exception: {}", e.what());
+        }
+
+        uint64_t latencyMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - task.submitted).count());
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --runningQueries;
+            QueryClassStats& stats = classStats[cls];
+            --stats.inFlight;
+            if (succeeded)
+                ++stats.completed;
+            else
+                ++stats.failed;
+            stats.totalLatencyMs += latencyMs;
+            stats.maxLatencyMs = std::max(stats.maxLatencyMs, latencyMs);
+        }
+        condition_.notify_one();
+    }
+}
 
+// Stop the pool: queued queries resolve to an empty string, in-flight queries
+// are allowed to finish and every worker is joined.
+void QueryManager::shutdown() {
+    std::array<std::deque<QueryTask>, QUERY_PRIORITY_COUNT> pending;
+    std::vector<std::thread> threads;
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        --currentQueries;
-        if (!taskQueue.empty() && (maxConcurrentQueries == 0 || currentQueries < maxConcurrentQueries)) {
-            QueryTask task = std::move(taskQueue.front());
-            taskQueue.pop();
-            ++currentQueries;
-            std::thread(&QueryManager::processQuery, this, task.prompt, std::move(task.promise)).detach();
+        if (stopping && workers.empty())
+            return;
+        stopping = true;
+        pending.swap(taskQueues);
+        threads.swap(workers);
+        for (QueryClassStats& stats : classStats)
+        {
+            stats.queued = 0;
+        }
+    }
+    condition_.notify_all();
+
+    for (auto& queue : pending)
+    {
+        for (QueryTask& task : queue)
+        {
+            task.onComplete("");
         }
     }
+    for (std::thread& worker : threads)
+    {
+        if (worker.joinable())
+            worker.join();
+    }
 }
@@ -1,32 +1,154 @@
 #ifndef MOD_OLLAMA_CHAT_QUERYMANAGER_H
 #define MOD_OLLAMA_CHAT_QUERYMANAGER_H
 
+#include <array>
+#include <chrono>
+#include <cstdint>
 #include <string>
 #include <future>
 #include <mutex>
-#include <queue>
+#include <condition_variable>
+#include <deque>
 #include <thread>
+#include <vector>
+#include <functional>
 
-std::string QueryOllamaAPI(const std::string& prompt);
+// What a query is for; selects the model profile (OllamaChat.Profile.<Name>.*).
+enum class QueryPurpose : uint8_t
+{
+    Conversation = 0,
+    Event,
+    Random,
+    Sentiment,
+    Guild,
+    Count
+};
+
+constexpr size_t QUERY_PURPOSE_COUNT = static_cast<size_t>(QueryPurpose::Count);
+
+const char* QueryPurposeName(QueryPurpose purpose);
+
+// One turn of an earlier conversation, sent as a /api/chat message.
+struct OllamaMessage
+{
+    std::string role; // "user" or "assistant"
+    std::string content;
+};
+
+// One LLM request. The system prompt, when set, replaces OllamaChat.SystemPrompt
+// so a stable per-bot prefix can be sent separately from the per-turn prompt.
+// History is only sent in chat mode (OllamaChat.UseChatEndpoint); it goes
+// between the system message and the prompt.
+struct OllamaRequest
+{
+    std::string prompt;
+    std::string system;
+    std::vector<OllamaMessage> history;
+    QueryPurpose purpose = QueryPurpose::Conversation;
+};
+
+std::string QueryOllamaAPI(const OllamaRequest& request);
+std::string QueryOllamaAPIStreaming(const OllamaRequest& request, const std::function<bool(const std::string&)>& onSentence);
 
+// Priority classes for queued queries, highest priority first.
+enum class QueryPriority : uint8_t
+{
+    Whisper = 0,    // direct whisper from a real player
+    Mention,        // bot addressed by name
+    PartyGuild,     // real player talking in party/raid/guild/say/channel
+    Event,          // game event chatter
+    Ambient,        // random chatter and bot-to-bot replies
+    Background,     // analysis work such as sentiment classification
+    Count
+};
+
+constexpr size_t QUERY_PRIORITY_COUNT = static_cast<size_t>(QueryPriority::Count);
+
+const char* QueryPriorityName(QueryPriority priority);
+
+// Per-class queue counters reported by QueryManager::getStats().
+struct QueryClassStats
+{
+    size_t   queued = 0;      // currently waiting
+    size_t   peakQueued = 0;  // highest queue depth seen
+    uint64_t submitted = 0;   // accepted into the queue
+    uint64_t dropped = 0;     // rejected or shed because the queue was full
+    size_t   inFlight = 0;    // currently running on a worker
+    uint64_t completed = 0;   // finished with a non-empty reply
+    uint64_t failed = 0;      // finished with an empty reply or an exception
+    uint64_t totalLatencyMs = 0; // submit-to-reply time summed over finished queries
+    uint64_t maxLatencyMs = 0;
+};
+
+// Callbacks of an asynchronous query, all run on the worker thread.
+// Prepare runs right before the query and may fill in the request; returning
+// false skips the query.
+using QueryPrepareFn = std::function<bool(OllamaRequest&)>;
+// Called once per streamed sentence; returning false stops the stream.
+using QuerySentenceFn = std::function<bool(const std::string&)>;
+// Called exactly once with the reply, or with an empty string if the query
+// failed, was skipped, was dropped from a full queue or the manager shut down.
+using QueryCompleteFn = std::function<void(std::string)>;
+
+// Runs LLM queries on a fixed pool of persistent worker threads fed from a
+// bounded queue. Workers are started lazily and joined by shutdown().
 class QueryManager {
 public:
     QueryManager();
+    ~QueryManager();
+
+    // Set the worker pool size (0 means one worker per hardware thread).
     void setMaxConcurrentQueries(int maxQueries);
-    std::future<std::string> submitQuery(const std::string& prompt);
+    // Total concurrency the backends accept (0 if unlimited); sizes the pool when no explicit limit is set.
+    void setBackendCapacity(uint32_t capacity);
+    // Set the maximum number of queued (not yet running) queries (0 means no limit).
+    void setMaxQueueSize(int maxQueued);
+    // Choose strict priority (false) or weighted-fair (true) dequeueing.
+    void setWeightedScheduling(bool weighted);
+    // Relative weights per priority class used by weighted-fair dequeueing.
+    void setPriorityWeights(const std::vector<uint32_t>& weights);
+    std::future<std::string> submitQuery(const std::string& prompt, QueryPriority priority = QueryPriority::Ambient,
+                                         QueryPurpose purpose = QueryPurpose::Conversation);
+    // Submit a full request. If onSentence is set the reply is streamed and onSentence
+    // is called on the worker thread for each sentence as it is generated.
+    std::future<std::string> submitQuery(OllamaRequest request, QueryPriority priority,
+                                         std::function<bool(const std::string&)> onSentence = nullptr);
+    // Submit a request and hand the reply to onComplete on the worker, so no
+    // thread has to wait for it. If onSentence is set the reply is streamed.
+    void submitQueryAsync(OllamaRequest request, QueryPriority priority, QueryCompleteFn onComplete,
+                          QuerySentenceFn onSentence = nullptr, QueryPrepareFn prepare = nullptr);
+    std::array<QueryClassStats, QUERY_PRIORITY_COUNT> getStats();
+    // Stop accepting work, fail any queued queries and join all workers.
+    void shutdown();
 
 private:
     struct QueryTask {
-        std::string prompt;
-        std::promise<std::string> promise;
+        OllamaRequest request;
+        std::chrono::steady_clock::time_point submitted;
+        QueryCompleteFn onComplete;
+        QuerySentenceFn onSentence; // set for streaming queries
+        QueryPrepareFn prepare;
     };
 
-    void processQuery(const std::string& prompt, std::promise<std::string> promise);
+    void workerLoop();
+    void startWorkers(); // requires mutex_ held
+    size_t desiredWorkerCount() const;
+    size_t queuedCount() const; // requires mutex_ held
+    size_t pickNextClass();     // requires mutex_ held, at least one task queued
 
-    int maxConcurrentQueries; // 0 means no limit
-    int currentQueries;
+    int maxConcurrentQueries; // 0 means hardware concurrency
+    int maxQueueSize;         // 0 means no limit
+    uint32_t backendCapacity; // 0 means unknown/unlimited
+    size_t runningQueries;
+    bool stopping;
+    bool weightedScheduling;
+    std::array<uint32_t, QUERY_PRIORITY_COUNT> classWeights;
+    std::array<int64_t, QUERY_PRIORITY_COUNT> classCredits;
+    std::array<QueryClassStats, QUERY_PRIORITY_COUNT> classStats;
     std::mutex mutex_;
-    std::queue<QueryTask> taskQueue;
+    std::condition_variable condition_;
+    std::array<std::deque<QueryTask>, QUERY_PRIORITY_COUNT> taskQueues;
+    std::vector<std::thread> workers;
 };
 
 #endif // MOD_OLLAMA_CHAT_QUERYMANAGER_H
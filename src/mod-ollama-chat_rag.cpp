@@ -2,11 +2,7 @@
 #include "mod-ollama-chat_config.h"
 #include "Log.h"
 #include <filesystem>
-#include <fstream>
-#include <algorithm>
-#include <cmath>
 #include <sstream>
-#include <unordered_set>
 
 namespace fs = std::filesystem;
 
@@ -14,47 +10,76 @@ OllamaRAGSystem::OllamaRAGSystem() : m_initialized(false) {}
 
 OllamaRAGSystem::~OllamaRAGSystem() {}
 
+static RAGFieldBoosts GetConfiguredFieldBoosts()
+{
+    RAGFieldBoosts boosts;
+    boosts.title = g_RAGTitleBoost;
+    boosts.keywords = g_RAGKeywordsBoost;
+    boosts.tags = g_RAGTagsBoost;
+    boosts.content = g_RAGContentBoost;
+    return boosts;
+}
+
 bool OllamaRAGSystem::Initialize()
 {
     if (m_initialized) {
         return true;
     }
 
-    m_ragEntries.clear();
-    m_vocabulary.clear();
+    if (!g_RAGIndexFile.empty() && OpenIndexFile(g_RAGIndexFile)) {
+        m_initialized = true;
+        LOG_INFO("server.loading", "[Ollama Chat RAG] Mapped index {} with {} entries and {} vocabulary terms",
+                 g_RAGIndexFile, m_index.EntryCount(), m_index.TermCount());
+        return true;
+    }
 
     // Use the configured RAG data path directly
     std::string fullPath = g_RAGDataPath;
 
-    if (!LoadRAGDataFromDirectory(fullPath)) {
+    std::vector<RAGEntry> entries;
+    if (!LoadRAGDataFromDirectory(fullPath, entries)) {
         LOG_ERROR("server.loading", "[Ollama Chat RAG] Failed to load RAG data from directory: {}", fullPath);
         return false;
     }
 
-    // Build vocabulary from all entries
-    std::unordered_set<std::string> vocabSet;
-    for (const auto& entry : m_ragEntries) {
-        auto tokens = TokenizeText(PreprocessText(entry.title + " " + entry.content));
-        for (const auto& token : tokens) {
-            vocabSet.insert(token);
-        }
-        for (const auto& keyword : entry.keywords) {
-            auto keywordTokens = TokenizeText(PreprocessText(keyword));
-            for (const auto& token : keywordTokens) {
-                vocabSet.insert(token);
-            }
-        }
+    std::vector<char> buffer;
+    std::string error;
+    if (!BuildRAGIndex(entries, GetConfiguredFieldBoosts(), buffer, error) || !m_index.Load(std::move(buffer), error)) {
+        LOG_ERROR("server.loading", "[Ollama Chat RAG] Failed to build index: {}", error);
+        return false;
     }
-    m_vocabulary.assign(vocabSet.begin(), vocabSet.end());
 
     m_initialized = true;
     LOG_INFO("server.loading", "[Ollama Chat RAG] Initialized with {} entries and {} vocabulary terms",
-             m_ragEntries.size(), m_vocabulary.size());
+             m_index.EntryCount(), m_index.TermCount());
 
     return true;
 }
 
-bool OllamaRAGSystem::LoadRAGDataFromDirectory(const std::string& directoryPath)
+bool OllamaRAGSystem::OpenIndexFile(const std::string& filePath)
+{
+    std::string error;
+    if (!m_index.Open(filePath, error)) {
+        LOG_ERROR("server.loading", "[Ollama Chat RAG] Cannot use index file, loading JSON instead: {}", error);
+        return false;
+    }
+
+    // The boosts are baked into the postings, so a stale index would ignore the config
+    RAGFieldBoosts indexBoosts = m_index.Boosts();
+    RAGFieldBoosts configBoosts = GetConfiguredFieldBoosts();
+    if (indexBoosts.title != configBoosts.title || indexBoosts.keywords != configBoosts.keywords ||
+        indexBoosts.tags != configBoosts.tags || indexBoosts.content != configBoosts.content) {
+        LOG_ERROR("server.loading", "[Ollama Chat RAG] Index file {} was built with field boosts {}/{}/{}/{} (title/keywords/tags/content), "
+                  "loading JSON instead. Rebuild it with rag-index-builder.",
+                  filePath, indexBoosts.title, indexBoosts.keywords, indexBoosts.tags, indexBoosts.content);
+        m_index.Close();
+        return false;
+    }
+
+    return true;
+}
+
+bool OllamaRAGSystem::LoadRAGDataFromDirectory(const std::string& directoryPath, std::vector<RAGEntry>& entries)
 {
     try {
         if (!fs::exists(directoryPath)) {
@@ -70,78 +95,31 @@ bool OllamaRAGSystem::LoadRAGDataFromDirectory(const std::string& directoryPath)
         uint32_t loadedFiles = 0;
         for (const auto& entry : fs::directory_iterator(directoryPath)) {
             if (entry.is_regular_file() && entry.path().extension() == ".json") {
-                if (LoadRAGDataFromFile(entry.path().string())) {
-                    loadedFiles++;
+                std::string filePath = entry.path().string();
+                std::vector<std::string> warnings;
+                std::string error;
+                size_t entriesBefore = entries.size();
+                bool loaded = LoadRAGEntriesFromFile(filePath, entries, warnings, error);
+                for (const auto& warning : warnings) {
+                    LOG_ERROR("server.loading", "[Ollama Chat RAG] {}", warning);
                 }
-            }
-        }
-
-        LOG_INFO("server.loading", "[Ollama Chat RAG] Loaded {} JSON files from {}", loadedFiles, directoryPath);
-        return loadedFiles > 0;
-    }
-    catch (const std::exception& e) {
-        LOG_ERROR("server.loading", "[Ollama Chat RAG] Error loading directory {}: {}", directoryPath, e.what());
-        return false;
-    }
-}
-
-bool OllamaRAGSystem::LoadRAGDataFromFile(const std::string& filePath)
-{
-    try {
-        std::ifstream file(filePath);
-        if (!file.is_open()) {
-            LOG_ERROR("server.loading", "[Ollama Chat RAG] Cannot open file: {}", filePath);
-            return false;
-        }
-
-        nlohmann::json jsonData;
-        file >> jsonData;
-
-        if (!jsonData.is_array()) {
-            LOG_ERROR("server.loading", "[Ollama Chat RAG] JSON file must contain an array of entries: {}", filePath);
-            return false;
-        }
-
-        uint32_t entriesLoaded = 0;
-        for (const auto& item : jsonData) {
-            try {
-                RAGEntry entry;
-                entry.id = item.value("id", "");
-                entry.title = item.value("title", "");
-                entry.content = item.value("content", "");
-
-                if (entry.id.empty() || entry.content.empty()) {
-                    LOG_ERROR("server.loading", "[Ollama Chat RAG] Entry missing required 'id' or 'content' field in file: {}", filePath);
+                if (!loaded) {
+                    LOG_ERROR("server.loading", "[Ollama Chat RAG] {}", error);
                     continue;
                 }
 
-                // Load keywords array
-                if (item.contains("keywords") && item["keywords"].is_array()) {
-                    for (const auto& keyword : item["keywords"]) {
-                        entry.keywords.push_back(keyword.get<std::string>());
-                    }
-                }
-
-                // Load tags array
-                if (item.contains("tags") && item["tags"].is_array()) {
-                    for (const auto& tag : item["tags"]) {
-                        entry.tags.push_back(tag.get<std::string>());
-                    }
+                LOG_INFO("server.loading", "[Ollama Chat RAG] Loaded {} entries from {}", entries.size() - entriesBefore, filePath);
+                if (entries.size() > entriesBefore) {
+                    loadedFiles++;
                 }
-
-                m_ragEntries.push_back(entry);
-                entriesLoaded++;
-            }
-            catch (const std::exception& e) {
-                LOG_ERROR("server.loading", "[Ollama Chat RAG] Error parsing entry in {}: {}", filePath, e.what());
             }
         }
 
-        LOG_INFO("server.loading", "[Ollama Chat RAG] Loaded {} entries from {}", entriesLoaded, filePath);
-        return entriesLoaded > 0;
+        LOG_INFO("server.loading", "[Ollama Chat RAG] Loaded {} JSON files from {}", loadedFiles, directoryPath);
+        return loadedFiles > 0;
     }
     catch (const std::exception& e) {
-        LOG_ERROR("server.loading", "[Ollama Chat RAG] Error loading file {}: {}", filePath, e.what());
+        LOG_ERROR("server.loading", "[Ollama Chat RAG] Error loading directory {}: {}", directoryPath, e.what());
         return false;
     }
 }
@@ -154,24 +132,10 @@ std::vector<RAGResult> OllamaRAGSystem::RetrieveRelevantInfo(const std::string&
         return results;
     }
 
-    for (const auto& entry : m_ragEntries) {
-        float similarity = CalculateSimilarity(query, entry);
-        if (similarity >= similarityThreshold) {
-            results.push_back({&entry, similarity});
-        }
-    }
-
-    // Sort by similarity (highest first)
-    std::sort(results.begin(), results.end(),
-              [](const RAGResult& a, const RAGResult& b) {
-                  return a.similarity > b.similarity;
-              });
-
-    // Limit results
-    if (results.size() > maxResults) {
-        results.resize(maxResults);
+    for (const RAGSearchHit& hit : m_index.Search(query, maxResults, similarityThreshold)) {
+        results.push_back({m_index.EntryId(hit.entryIndex), m_index.EntryTitle(hit.entryIndex),
+                           m_index.EntryContent(hit.entryIndex), hit.score});
     }
-
     return results;
 }
 
@@ -184,7 +148,7 @@ std::string OllamaRAGSystem::GetFormattedRAGInfo(const std::vector<RAGResult>& r
     std::stringstream ss;
     for (size_t i = 0; i < results.size(); ++i) {
         const auto& result = results[i];
-        ss << "- " << result.entry->title << ": " << result.entry->content;
+        ss << "- " << result.title << ": " << result.content;
         if (i < results.size() - 1) {
             ss << "\n";
         }
@@ -192,92 +156,3 @@ std::string OllamaRAGSystem::GetFormattedRAGInfo(const std::vector<RAGResult>& r
 
     return ss.str();
 }
-
-float OllamaRAGSystem::CalculateSimilarity(const std::string& query, const RAGEntry& entry)
-{
-    // Combine entry content with keywords for better matching
-    std::string entryText = entry.title + " " + entry.content;
-    for (const auto& keyword : entry.keywords) {
-        entryText += " " + keyword;
-    }
-
-    // Simple TF-IDF like similarity using term frequency vectors
-    auto queryVector = TextToTFVector(PreprocessText(query), m_vocabulary);
-    auto entryVector = TextToTFVector(PreprocessText(entryText), m_vocabulary);
-
-    return CalculateCosineSimilarity(queryVector, entryVector);
-}
-
-std::string OllamaRAGSystem::PreprocessText(const std::string& text) const
-{
-    std::string result = text;
-    // Convert to lowercase
-    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
-
-    // Remove punctuation (simple approach)
-    result.erase(std::remove_if(result.begin(), result.end(),
-                                [](char c) { return std::ispunct(c); }), result.end());
-
-    return result;
-}
-
-std::vector<std::string> OllamaRAGSystem::TokenizeText(const std::string& text) const
-{
-    std::vector<std::string> tokens;
-    std::stringstream ss(text);
-    std::string token;
-    while (ss >> token) {
-        if (!token.empty()) {
-            tokens.push_back(token);
-        }
-    }
-    return tokens;
-}
-
-float OllamaRAGSystem::CalculateCosineSimilarity(const std::vector<float>& vec1, const std::vector<float>& vec2) const
-{
-    if (vec1.size() != vec2.size()) {
-        return 0.0f;
-    }
-
-    float dotProduct = 0.0f;
-    float norm1 = 0.0f;
-    float norm2 = 0.0f;
-
-    for (size_t i = 0; i < vec1.size(); ++i) {
-        dotProduct += vec1[i] * vec2[i];
-        norm1 += vec1[i] * vec1[i];
-        norm2 += vec2[i] * vec2[i];
-    }
-
-    norm1 = std::sqrt(norm1);
-    norm2 = std::sqrt(norm2);
-
-    if (norm1 == 0.0f || norm2 == 0.0f) {
-        return 0.0f;
-    }
-
-    return dotProduct / (norm1 * norm2);
-}
-
-std::vector<float> OllamaRAGSystem::TextToTFVector(const std::string& text, const std::vector<std::string>& vocabulary) const
-{
-    auto tokens = TokenizeText(text);
-    std::unordered_map<std::string, int> termFreq;
-
-    // Count term frequencies
-    for (const auto& token : tokens) {
-        termFreq[token]++;
-    }
-
-    // Create TF vector
-    std::vector<float> vector(vocabulary.size(), 0.0f);
-    for (size_t i = 0; i < vocabulary.size(); ++i) {
-        auto it = termFreq.find(vocabulary[i]);
-        if (it != termFreq.end()) {
-            vector[i] = static_cast<float>(it->second);
-        }
-    }
-
-    return vector;
-}
\ No newline at end of file
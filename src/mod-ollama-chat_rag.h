@@ -1,21 +1,16 @@
 #ifndef MOD_OLLAMA_CHAT_RAG_H
 #define MOD_OLLAMA_CHAT_RAG_H
 
+#include "mod-ollama-chat_rag_index.h"
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
-#include <nlohmann/json.hpp>
-
-struct RAGEntry {
-    std::string id;
-    std::string title;
-    std::string content;
-    std::vector<std::string> keywords;
-    std::vector<std::string> tags;
-};
 
+// Views into the RAG index, valid as long as the system that returned them
 struct RAGResult {
-    const RAGEntry* entry;
+    std::string_view id;
+    std::string_view title;
+    std::string_view content;
     float similarity;
 };
 
@@ -24,7 +19,8 @@ public:
     OllamaRAGSystem();
     ~OllamaRAGSystem();
 
-    // Initialize the RAG system by loading JSON data files
+    // Initialize the RAG system from the prebuilt index file, or by loading
+    // the JSON data files when there is none
     bool Initialize();
 
     // Retrieve relevant information based on a query
@@ -34,31 +30,16 @@ public:
     std::string GetFormattedRAGInfo(const std::vector<RAGResult>& results);
 
 private:
-    // Load RAG data from JSON files in the specified directory
-    bool LoadRAGDataFromDirectory(const std::string& directoryPath);
-
-    // Load a single JSON file
-    bool LoadRAGDataFromFile(const std::string& filePath);
-
-    // Calculate similarity between query and entry
-    float CalculateSimilarity(const std::string& query, const RAGEntry& entry);
+    // Map the prebuilt index file, if configured and built with the current field boosts
+    bool OpenIndexFile(const std::string& filePath);
 
-    // Simple text preprocessing (lowercase, remove punctuation)
-    std::string PreprocessText(const std::string& text) const;
-
-    // Split text into words
-    std::vector<std::string> TokenizeText(const std::string& text) const;
-
-    // Calculate cosine similarity between two vectors
-    float CalculateCosineSimilarity(const std::vector<float>& vec1, const std::vector<float>& vec2) const;
-
-    // Convert text to simple TF vector (term frequency)
-    std::vector<float> TextToTFVector(const std::string& text, const std::vector<std::string>& vocabulary) const;
+    // Load RAG data from JSON files in the specified directory
+    bool LoadRAGDataFromDirectory(const std::string& directoryPath, std::vector<RAGEntry>& entries);
 
 private:
-    std::vector<RAGEntry> m_ragEntries;
-    std::vector<std::string> m_vocabulary;
+    // Entry texts, term dictionary and BM25 postings; see RAGIndex
+    RAGIndex m_index;
     bool m_initialized;
 };
 
-#endif // MOD_OLLAMA_CHAT_RAG_H
\ No newline at end of file
+#endif // MOD_OLLAMA_CHAT_RAG_H
@@ -0,0 +1,699 @@
+#include "mod-ollama-chat_rag_index.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static constexpr char RAG_INDEX_MAGIC[8] = { 'O', 'C', 'R', 'A', 'G', 'I', 'D', 'X' };
+static constexpr uint32_t RAG_INDEX_BYTE_ORDER = 0x01020304;
+
+struct RAGIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;                 // RAG_INDEX_BYTE_ORDER as written by the builder
+    uint32_t entryCount;
+    uint32_t termCount;
+    uint32_t postingCount;
+    uint32_t reserved;
+    RAGFieldBoosts boosts;
+    uint64_t fileSize;
+    uint64_t entriesOffset;
+    uint64_t termsOffset;
+    uint64_t postingOffsetsOffset;
+    uint64_t postingEntriesOffset;
+    uint64_t postingWeightsOffset;
+    uint64_t textOffset;
+    uint64_t textSize;
+};
+
+struct RAGIndexEntry {
+    uint32_t idOffset;
+    uint32_t idLength;
+    uint32_t titleOffset;
+    uint32_t titleLength;
+    uint32_t contentOffset;
+    uint32_t contentLength;
+};
+
+struct RAGIndexTerm {
+    uint32_t textOffset;
+    uint32_t textLength;
+    float idf;
+    float maxWeight;
+};
+
+std::string RAGPreprocessText(const std::string& text)
+{
+    std::string result = text;
+    // Convert to lowercase
+    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+
+    // Remove punctuation (simple approach)
+    result.erase(std::remove_if(result.begin(), result.end(),
+                                [](char c) { return std::ispunct(c); }), result.end());
+
+    return result;
+}
+
+// English function words and common verbs of chat. The knowledge base is too
+// small for IDF to tell them apart: "you" or "how" appear in only a few
+// entries, so they would rank as rare terms and let small talk match.
+static const std::unordered_set<std::string> RAG_STOP_WORDS = {
+    "a", "about", "all", "am", "an", "and", "any", "are", "as", "at", "be", "been", "being", "but", "by",
+    "can", "cool", "could", "did", "do", "does", "doing", "for", "from", "fun", "get", "go", "going", "good",
+    "got", "great", "had", "has", "have", "he", "her", "here", "him", "his", "how", "i", "if", "im", "in",
+    "into", "is", "it", "its", "just", "know", "like", "many", "me", "much", "my", "nice", "no", "not", "of",
+    "on", "or", "our", "really", "say", "she", "so", "some", "tell", "than", "that", "the", "their", "them",
+    "then", "there", "these", "they", "think", "this", "those", "to", "too", "up", "us", "very", "want",
+    "was", "way", "we", "well", "were", "what", "when", "where", "which", "who", "whom", "why", "will",
+    "with", "would", "you", "your", "youre"
+};
+
+std::vector<std::string> RAGTokenizeText(const std::string& text)
+{
+    std::vector<std::string> tokens;
+    std::stringstream ss(text);
+    std::string token;
+    while (ss >> token) {
+        if (!token.empty() && !RAG_STOP_WORDS.count(token)) {
+            tokens.push_back(token);
+        }
+    }
+    return tokens;
+}
+
+float RAGTermIdf(uint32_t entryCount, uint32_t documentFrequency)
+{
+    float entries = static_cast<float>(entryCount);
+    float frequency = static_cast<float>(documentFrequency);
+    return std::log(1.0f + (entries - frequency + 0.5f) / (frequency + 0.5f));
+}
+
+bool LoadRAGEntriesFromFile(const std::string& filePath, std::vector<RAGEntry>& entries,
+                            std::vector<std::string>& warnings, std::string& error)
+{
+    try {
+        std::ifstream file(filePath);
+        if (!file.is_open()) {
+            error = "Cannot open file: " + filePath;
+            return false;
+        }
+
+        nlohmann::json jsonData;
+        file >> jsonData;
+
+        if (!jsonData.is_array()) {
+            error = "JSON file must contain an array of entries: " + filePath;
+            return false;
+        }
+
+        for (const auto& item : jsonData) {
+            try {
+                RAGEntry entry;
+                entry.id = item.value("id", "");
+                entry.title = item.value("title", "");
+                entry.content = item.value("content", "");
+
+                if (entry.id.empty() || entry.content.empty()) {
+                    warnings.push_back("Entry missing required 'id' or 'content' field in file: " + filePath);
+                    continue;
+                }
+
+                // Load keywords array
+                if (item.contains("keywords") && item["keywords"].is_array()) {
+                    for (const auto& keyword : item["keywords"]) {
+                        entry.keywords.push_back(keyword.get<std::string>());
+                    }
+                }
+
+                // Load tags array
+                if (item.contains("tags") && item["tags"].is_array()) {
+                    for (const auto& tag : item["tags"]) {
+                        entry.tags.push_back(tag.get<std::string>());
+                    }
+                }
+
+                entries.push_back(std::move(entry));
+            }
+            catch (const std::exception& e) {
+                warnings.push_back("Error parsing entry in " + filePath + ": " + e.what());
+            }
+        }
+        return true;
+    }
+    catch (const std::exception& e) {
+        error = "Error loading file " + filePath + ": " + e.what();
+        return false;
+    }
+}
+
+template <typename T>
+static uint64_t AppendSection(std::vector<char>& out, const T* data, size_t count)
+{
+    out.resize((out.size() + 7) & ~size_t(7), 0);
+    uint64_t offset = out.size();
+    if (count > 0) {
+        out.resize(out.size() + count * sizeof(T));
+        std::memcpy(out.data() + offset, data, count * sizeof(T));
+    }
+    return offset;
+}
+
+bool BuildRAGIndex(const std::vector<RAGEntry>& entries, const RAGFieldBoosts& boosts,
+                   std::vector<char>& out, std::string& error)
+{
+    if (entries.size() >= std::numeric_limits<uint32_t>::max()) {
+        error = "Too many entries for one index";
+        return false;
+    }
+
+    // Each entry's boosted term frequencies (BM25F: a term's frequency in a
+    // field counts times that field's boost) and boosted length, keyed by the
+    // order terms were first seen in
+    std::unordered_map<std::string, uint32_t> seenTerms;
+    std::vector<const std::string*> seenTermText;
+    std::vector<std::unordered_map<uint32_t, float>> entryTerms(entries.size());
+    std::vector<float> entryLengths(entries.size(), 0.0f);
+    for (size_t entryIndex = 0; entryIndex < entries.size(); ++entryIndex) {
+        const RAGEntry& entry = entries[entryIndex];
+        auto& termFreq = entryTerms[entryIndex];
+
+        auto addField = [&](const std::string& text, float boost) {
+            if (boost <= 0.0f) {
+                return;
+            }
+            for (auto& token : RAGTokenizeText(RAGPreprocessText(text))) {
+                auto [it, inserted] = seenTerms.try_emplace(std::move(token), static_cast<uint32_t>(seenTermText.size()));
+                if (inserted) {
+                    seenTermText.push_back(&it->first);
+                }
+                termFreq[it->second] += boost;
+                entryLengths[entryIndex] += boost;
+            }
+        };
+
+        addField(entry.title, boosts.title);
+        addField(entry.content, boosts.content);
+        for (const auto& keyword : entry.keywords) {
+            addField(keyword, boosts.keywords);
+        }
+        for (const auto& tag : entry.tags) {
+            addField(tag, boosts.tags);
+        }
+    }
+
+    // Term ids follow the sorted dictionary so queries can binary search it
+    std::vector<uint32_t> sortedTerms(seenTermText.size());
+    for (uint32_t i = 0; i < sortedTerms.size(); ++i) {
+        sortedTerms[i] = i;
+    }
+    std::sort(sortedTerms.begin(), sortedTerms.end(),
+              [&](uint32_t a, uint32_t b) {
+                  return *seenTermText[a] < *seenTermText[b];
+              });
+    std::vector<uint32_t> termIdOf(seenTermText.size());
+    for (uint32_t termId = 0; termId < sortedTerms.size(); ++termId) {
+        termIdOf[sortedTerms[termId]] = termId;
+    }
+
+    std::vector<uint32_t> termCounts(sortedTerms.size(), 0);
+    for (const auto& termFreq : entryTerms) {
+        for (const auto& [seenId, freq] : termFreq) {
+            termCounts[termIdOf[seenId]]++;
+        }
+    }
+
+    float averageLength = 0.0f;
+    for (float length : entryLengths) {
+        averageLength += length;
+    }
+    averageLength = entries.empty() ? 0.0f : averageLength / entries.size();
+
+    // Entry and term strings share one blob
+    std::string text;
+    auto addText = [&](std::string_view value, uint32_t& offset, uint32_t& length) {
+        offset = static_cast<uint32_t>(text.size());
+        length = static_cast<uint32_t>(value.size());
+        text.append(value);
+    };
+
+    std::vector<RAGIndexEntry> indexEntries(entries.size());
+    for (size_t entryIndex = 0; entryIndex < entries.size(); ++entryIndex) {
+        const RAGEntry& entry = entries[entryIndex];
+        RAGIndexEntry& indexEntry = indexEntries[entryIndex];
+        addText(entry.id, indexEntry.idOffset, indexEntry.idLength);
+        addText(entry.title, indexEntry.titleOffset, indexEntry.titleLength);
+        addText(entry.content, indexEntry.contentOffset, indexEntry.contentLength);
+    }
+
+    // Rare terms weigh more; a term in every entry still counts a little
+    std::vector<RAGIndexTerm> indexTerms(sortedTerms.size());
+    for (uint32_t termId = 0; termId < sortedTerms.size(); ++termId) {
+        RAGIndexTerm& indexTerm = indexTerms[termId];
+        addText(*seenTermText[sortedTerms[termId]], indexTerm.textOffset, indexTerm.textLength);
+        indexTerm.idf = RAGTermIdf(static_cast<uint32_t>(entries.size()), termCounts[termId]);
+        indexTerm.maxWeight = 0.0f;
+    }
+
+    if (text.size() > std::numeric_limits<uint32_t>::max()) {
+        error = "Entry text exceeds 4 GiB";
+        return false;
+    }
+
+    // Lay the postings out term by term, in entry order within a term
+    std::vector<uint32_t> postingOffsets(sortedTerms.size() + 1, 0);
+    for (size_t termId = 0; termId < sortedTerms.size(); ++termId) {
+        postingOffsets[termId + 1] = postingOffsets[termId] + termCounts[termId];
+    }
+    std::vector<uint32_t> postingEntries(postingOffsets.back());
+    std::vector<float> postingWeights(postingOffsets.back());
+
+    std::vector<uint32_t> fill(postingOffsets.begin(), postingOffsets.end() - 1);
+    for (uint32_t entryIndex = 0; entryIndex < entryTerms.size(); ++entryIndex) {
+        float lengthNorm = averageLength > 0.0f ? entryLengths[entryIndex] / averageLength : 1.0f;
+        float saturation = RAG_BM25_K1 * (1.0f - RAG_BM25_B + RAG_BM25_B * lengthNorm);
+        for (const auto& [seenId, freq] : entryTerms[entryIndex]) {
+            uint32_t termId = termIdOf[seenId];
+            uint32_t slot = fill[termId]++;
+            float weight = indexTerms[termId].idf * freq * (RAG_BM25_K1 + 1.0f) / (freq + saturation);
+            postingEntries[slot] = entryIndex;
+            postingWeights[slot] = weight;
+            indexTerms[termId].maxWeight = std::max(indexTerms[termId].maxWeight, weight);
+        }
+    }
+
+    RAGIndexHeader header = {};
+    std::memcpy(header.magic, RAG_INDEX_MAGIC, sizeof(header.magic));
+    header.version = RAG_INDEX_VERSION;
+    header.byteOrder = RAG_INDEX_BYTE_ORDER;
+    header.entryCount = static_cast<uint32_t>(indexEntries.size());
+    header.termCount = static_cast<uint32_t>(indexTerms.size());
+    header.postingCount = postingOffsets.back();
+    header.boosts = boosts;
+
+    out.clear();
+    out.resize(sizeof(header));
+    header.entriesOffset = AppendSection(out, indexEntries.data(), indexEntries.size());
+    header.termsOffset = AppendSection(out, indexTerms.data(), indexTerms.size());
+    header.postingOffsetsOffset = AppendSection(out, postingOffsets.data(), postingOffsets.size());
+    header.postingEntriesOffset = AppendSection(out, postingEntries.data(), postingEntries.size());
+    header.postingWeightsOffset = AppendSection(out, postingWeights.data(), postingWeights.size());
+    header.textOffset = AppendSection(out, text.data(), text.size());
+    header.textSize = text.size();
+    header.fileSize = out.size();
+    std::memcpy(out.data(), &header, sizeof(header));
+    return true;
+}
+
+RAGIndex::~RAGIndex()
+{
+    Close();
+}
+
+bool RAGIndex::Open(const std::string& filePath, std::string& error)
+{
+    Close();
+
+#ifdef _WIN32
+    // No mapping here; reading the file still skips all parsing
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.is_open()) {
+        error = "Cannot open file: " + filePath;
+        return false;
+    }
+    std::vector<char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return Load(std::move(buffer), error);
+#else
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "Cannot open file: " + filePath + ": " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0) {
+        error = "Cannot read size of file: " + filePath;
+        close(fd);
+        return false;
+    }
+
+    // Shared read-only pages stay in the page cache across worldserver restarts
+    size_t size = static_cast<size_t>(fileStat.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        error = "Cannot map file: " + filePath + ": " + std::strerror(errno);
+        return false;
+    }
+
+    m_mapping = mapping;
+    m_mappingSize = size;
+    if (!Attach(static_cast<const char*>(mapping), size, error)) {
+        error = filePath + ": " + error;
+        Close();
+        return false;
+    }
+    return true;
+#endif
+}
+
+bool RAGIndex::Load(std::vector<char> buffer, std::string& error)
+{
+    Close();
+    m_buffer = std::move(buffer);
+    if (!Attach(m_buffer.data(), m_buffer.size(), error)) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void RAGIndex::Close()
+{
+#ifndef _WIN32
+    if (m_mapping) {
+        munmap(m_mapping, m_mappingSize);
+    }
+#endif
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+
+    m_header = nullptr;
+    m_entries = nullptr;
+    m_terms = nullptr;
+    m_postingOffsets = nullptr;
+    m_postingEntries = nullptr;
+    m_postingWeights = nullptr;
+    m_text = nullptr;
+}
+
+bool RAGIndex::Attach(const char* data, size_t size, std::string& error)
+{
+    if (size < sizeof(RAGIndexHeader)) {
+        error = "File is too small to be a RAG index";
+        return false;
+    }
+
+    const RAGIndexHeader* header = reinterpret_cast<const RAGIndexHeader*>(data);
+    if (std::memcmp(header->magic, RAG_INDEX_MAGIC, sizeof(header->magic)) != 0) {
+        error = "Not a RAG index";
+        return false;
+    }
+    if (header->version != RAG_INDEX_VERSION) {
+        error = "RAG index version " + std::to_string(header->version) + " does not match " + std::to_string(RAG_INDEX_VERSION);
+        return false;
+    }
+    if (header->byteOrder != RAG_INDEX_BYTE_ORDER) {
+        error = "RAG index was built on a machine with a different byte order";
+        return false;
+    }
+    if (header->fileSize != size) {
+        error = "RAG index is truncated or has trailing data";
+        return false;
+    }
+
+    // Every section must be aligned and lie within the file
+    auto sectionFits = [&](uint64_t offset, uint64_t count, size_t elementSize) {
+        return offset % 8 == 0 && offset <= size && count <= (size - offset) / elementSize;
+    };
+    if (!sectionFits(header->entriesOffset, header->entryCount, sizeof(RAGIndexEntry)) ||
+        !sectionFits(header->termsOffset, header->termCount, sizeof(RAGIndexTerm)) ||
+        !sectionFits(header->postingOffsetsOffset, uint64_t(header->termCount) + 1, sizeof(uint32_t)) ||
+        !sectionFits(header->postingEntriesOffset, header->postingCount, sizeof(uint32_t)) ||
+        !sectionFits(header->postingWeightsOffset, header->postingCount, sizeof(float)) ||
+        !sectionFits(header->textOffset, header->textSize, 1)) {
+        error = "RAG index has a section outside the file";
+        return false;
+    }
+
+    m_header = header;
+    m_entries = reinterpret_cast<const RAGIndexEntry*>(data + header->entriesOffset);
+    m_terms = reinterpret_cast<const RAGIndexTerm*>(data + header->termsOffset);
+    m_postingOffsets = reinterpret_cast<const uint32_t*>(data + header->postingOffsetsOffset);
+    m_postingEntries = reinterpret_cast<const uint32_t*>(data + header->postingEntriesOffset);
+    m_postingWeights = reinterpret_cast<const float*>(data + header->postingWeightsOffset);
+    m_text = data + header->textOffset;
+
+    // Queries index straight into the tables with these values, so a bad or
+    // foreign file must be rejected here rather than crash a query later
+    if (m_postingOffsets[0] != 0 || m_postingOffsets[header->termCount] != header->postingCount) {
+        error = "RAG index posting offsets are inconsistent";
+        return false;
+    }
+    for (uint32_t termId = 0; termId < header->termCount; ++termId) {
+        const RAGIndexTerm& term = m_terms[termId];
+        if (m_postingOffsets[termId] > m_postingOffsets[termId + 1] ||
+            uint64_t(term.textOffset) + term.textLength > header->textSize) {
+            error = "RAG index term table is inconsistent";
+            return false;
+        }
+
+        // Postings index the per-entry scores and are binary searched, so each
+        // term's entries must be valid and strictly ascending
+        for (uint32_t i = m_postingOffsets[termId]; i < m_postingOffsets[termId + 1]; ++i) {
+            if (m_postingEntries[i] >= header->entryCount ||
+                (i > m_postingOffsets[termId] && m_postingEntries[i] <= m_postingEntries[i - 1])) {
+                error = "RAG index postings are inconsistent";
+                return false;
+            }
+        }
+    }
+    for (uint32_t entryIndex = 0; entryIndex < header->entryCount; ++entryIndex) {
+        const RAGIndexEntry& entry = m_entries[entryIndex];
+        if (uint64_t(entry.idOffset) + entry.idLength > header->textSize ||
+            uint64_t(entry.titleOffset) + entry.titleLength > header->textSize ||
+            uint64_t(entry.contentOffset) + entry.contentLength > header->textSize) {
+            error = "RAG index entry table is inconsistent";
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t RAGIndex::EntryCount() const
+{
+    return m_header ? m_header->entryCount : 0;
+}
+
+uint32_t RAGIndex::TermCount() const
+{
+    return m_header ? m_header->termCount : 0;
+}
+
+RAGFieldBoosts RAGIndex::Boosts() const
+{
+    return m_header ? m_header->boosts : RAGFieldBoosts();
+}
+
+std::string_view RAGIndex::Text(uint32_t offset, uint32_t length) const
+{
+    return std::string_view(m_text + offset, length);
+}
+
+std::string_view RAGIndex::EntryId(uint32_t entryIndex) const
+{
+    return Text(m_entries[entryIndex].idOffset, m_entries[entryIndex].idLength);
+}
+
+std::string_view RAGIndex::EntryTitle(uint32_t entryIndex) const
+{
+    return Text(m_entries[entryIndex].titleOffset, m_entries[entryIndex].titleLength);
+}
+
+std::string_view RAGIndex::EntryContent(uint32_t entryIndex) const
+{
+    return Text(m_entries[entryIndex].contentOffset, m_entries[entryIndex].contentLength);
+}
+
+bool RAGIndex::FindTerm(std::string_view term, uint32_t& termId) const
+{
+    const RAGIndexTerm* begin = m_terms;
+    const RAGIndexTerm* end = m_terms + TermCount();
+    const RAGIndexTerm* it = std::lower_bound(begin, end, term,
+                                              [this](const RAGIndexTerm& entry, std::string_view value) {
+                                                  return Text(entry.textOffset, entry.textLength) < value;
+                                              });
+    if (it == end || Text(it->textOffset, it->textLength) != term) {
+        return false;
+    }
+    termId = static_cast<uint32_t>(it - begin);
+    return true;
+}
+
+float RAGIndex::TermIdf(uint32_t termId) const
+{
+    return m_terms[termId].idf;
+}
+
+float RAGIndex::TermMaxWeight(uint32_t termId) const
+{
+    return m_terms[termId].maxWeight;
+}
+
+std::vector<RAGSearchHit> RAGIndex::Search(const std::string& query, uint32_t maxResults, float threshold) const
+{
+    std::vector<RAGSearchHit> hits;
+    if (!IsOpen() || maxResults == 0) {
+        return hits;
+    }
+
+    // Term frequencies of the query terms that occur in some entry
+    std::unordered_map<uint32_t, int> queryFreq;
+    uint32_t unknownTokens = 0;
+    for (const auto& token : RAGTokenizeText(RAGPreprocessText(query))) {
+        uint32_t termId;
+        if (FindTerm(token, termId)) {
+            queryFreq[termId]++;
+        } else {
+            ++unknownTokens;
+        }
+    }
+    if (queryFreq.empty()) {
+        return hits;
+    }
+
+    // BM25 never exceeds IDF * (k1 + 1) per term. Dividing by that bound over
+    // every query word keeps the score in 0..1 and makes it the share of the
+    // query the entry covers. Words the knowledge base lacks count at the
+    // highest IDF, so a question about something else scores low.
+    float maxScore = unknownTokens * RAGTermIdf(EntryCount(), 0) * (RAG_BM25_K1 + 1.0f);
+    for (const auto& [termId, freq] : queryFreq) {
+        maxScore += freq * TermIdf(termId) * (RAG_BM25_K1 + 1.0f);
+    }
+
+    // Query terms ordered by the most they can add to any entry's score, with
+    // remainingBound[i] being what terms i.. can still add together
+    struct QueryTerm {
+        uint32_t termId;
+        float weight;
+        float bound;
+    };
+    std::vector<QueryTerm> terms;
+    terms.reserve(queryFreq.size());
+    for (const auto& [termId, freq] : queryFreq) {
+        float weight = freq / maxScore;
+        terms.push_back({termId, weight, weight * TermMaxWeight(termId)});
+    }
+    std::sort(terms.begin(), terms.end(),
+              [](const QueryTerm& a, const QueryTerm& b) {
+                  return a.bound > b.bound;
+              });
+    std::vector<float> remainingBound(terms.size() + 1, 0.0f);
+    for (size_t i = terms.size(); i-- > 0;) {
+        remainingBound[i] = remainingBound[i + 1] + terms[i].bound;
+    }
+
+    // BM25, accumulated term by term into per-thread scratch. Only the entries
+    // touched here are reset afterwards, so nothing is proportional to the corpus.
+    thread_local std::vector<float> scores;
+    thread_local std::vector<uint32_t> touched;
+    thread_local std::vector<uint32_t> candidates;
+    if (scores.size() < EntryCount()) {
+        scores.resize(EntryCount(), 0.0f);
+    }
+    touched.clear();
+
+    // Lowest score that can still make the results: the threshold, or once
+    // maxResults entries are known, the worst of them. Partial scores only
+    // grow, so the k-th best partial score is a safe floor.
+    float floor = threshold;
+    auto raiseFloor = [&](const std::vector<uint32_t>& entries) {
+        if (entries.size() < maxResults) {
+            return;
+        }
+        thread_local std::vector<float> partial;
+        partial.clear();
+        for (uint32_t entryIndex : entries) {
+            partial.push_back(scores[entryIndex]);
+        }
+        std::nth_element(partial.begin(), partial.begin() + (maxResults - 1), partial.end(), std::greater<float>());
+        floor = std::max(floor, partial[maxResults - 1]);
+    };
+
+    // MaxScore: while the terms left could still lift an unseen entry over the
+    // floor, walk their whole postings
+    size_t termIndex = 0;
+    for (; termIndex < terms.size() && remainingBound[termIndex] >= floor; ++termIndex) {
+        const QueryTerm& term = terms[termIndex];
+        for (uint32_t i = m_postingOffsets[term.termId]; i < m_postingOffsets[term.termId + 1]; ++i) {
+            uint32_t entryIndex = m_postingEntries[i];
+            if (scores[entryIndex] == 0.0f) {
+                touched.push_back(entryIndex);
+            }
+            scores[entryIndex] += term.weight * m_postingWeights[i];
+        }
+        raiseFloor(touched);
+    }
+
+    // The remaining terms can only finish entries already seen. Drop the ones
+    // that cannot reach the floor any more and look the rest up in each
+    // posting list, which is sorted by entry.
+    candidates.assign(touched.begin(), touched.end());
+    std::sort(candidates.begin(), candidates.end());
+    for (; termIndex < terms.size() && !candidates.empty(); ++termIndex) {
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                        [&](uint32_t entryIndex) {
+                                            return scores[entryIndex] + remainingBound[termIndex] < floor;
+                                        }), candidates.end());
+
+        const QueryTerm& term = terms[termIndex];
+        const uint32_t* postingsBegin = m_postingEntries + m_postingOffsets[term.termId];
+        const uint32_t* postingsEnd = m_postingEntries + m_postingOffsets[term.termId + 1];
+        const uint32_t* position = postingsBegin;
+        for (uint32_t entryIndex : candidates) {
+            position = std::lower_bound(position, postingsEnd, entryIndex);
+            if (position == postingsEnd) {
+                break;
+            }
+            if (*position == entryIndex) {
+                scores[entryIndex] += term.weight * m_postingWeights[position - m_postingEntries];
+            }
+        }
+        raiseFloor(candidates);
+    }
+
+    // Keep the best maxResults in a small min-heap instead of sorting every match
+    auto betterHit = [](const RAGSearchHit& a, const RAGSearchHit& b) {
+        return a.score > b.score;
+    };
+    hits.reserve(maxResults);
+    for (uint32_t entryIndex : candidates) {
+        float score = scores[entryIndex];
+        if (score < threshold) {
+            continue;
+        }
+        if (hits.size() < maxResults) {
+            hits.push_back({entryIndex, score});
+            std::push_heap(hits.begin(), hits.end(), betterHit);
+        } else if (score > hits.front().score) {
+            std::pop_heap(hits.begin(), hits.end(), betterHit);
+            hits.back() = {entryIndex, score};
+            std::push_heap(hits.begin(), hits.end(), betterHit);
+        }
+    }
+    std::sort_heap(hits.begin(), hits.end(), betterHit);
+
+    for (uint32_t entryIndex : touched) {
+        scores[entryIndex] = 0.0f;
+    }
+
+    return hits;
+}
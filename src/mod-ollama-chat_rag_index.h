@@ -0,0 +1,141 @@
+#ifndef MOD_OLLAMA_CHAT_RAG_INDEX_H
+#define MOD_OLLAMA_CHAT_RAG_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The RAG index format and everything needed to build it. This file only
+// depends on the standard library and nlohmann/json so the offline builder in
+// apps/rag-index-builder can compile it without the rest of the module.
+
+struct RAGEntry {
+    std::string id;
+    std::string title;
+    std::string content;
+    std::vector<std::string> keywords;
+    std::vector<std::string> tags;
+};
+
+// BM25F field weights, baked into the postings when the index is built
+struct RAGFieldBoosts {
+    float title = 2.0f;
+    float keywords = 1.5f;
+    float tags = 1.0f;
+    float content = 1.0f;
+};
+
+// BM25 parameters: term frequency saturation and length normalization
+constexpr float RAG_BM25_K1 = 1.2f;
+constexpr float RAG_BM25_B = 0.75f;
+
+// Bumped whenever the binary layout or the scoring baked into it changes
+constexpr uint32_t RAG_INDEX_VERSION = 2;
+
+// Simple text preprocessing (lowercase, remove punctuation)
+std::string RAGPreprocessText(const std::string& text);
+
+// Split text into words, leaving out common English function words
+std::vector<std::string> RAGTokenizeText(const std::string& text);
+
+// BM25 inverse document frequency of a term found in documentFrequency of
+// entryCount entries. A term in no entry gets the highest possible value.
+float RAGTermIdf(uint32_t entryCount, uint32_t documentFrequency);
+
+// Append the entries of one JSON file. Entries that cannot be used are
+// skipped and described in warnings; a file that cannot be read at all
+// fails with error set.
+bool LoadRAGEntriesFromFile(const std::string& filePath, std::vector<RAGEntry>& entries,
+                            std::vector<std::string>& warnings, std::string& error);
+
+// Compile entries into the binary index format
+bool BuildRAGIndex(const std::vector<RAGEntry>& entries, const RAGFieldBoosts& boosts,
+                   std::vector<char>& out, std::string& error);
+
+// An entry matched by RAGIndex::Search
+struct RAGSearchHit {
+    uint32_t entryIndex;
+    float score;        // share of the query's BM25 bound the entry reaches, 0..1
+};
+
+struct RAGIndexHeader;
+struct RAGIndexEntry;
+struct RAGIndexTerm;
+
+// Read-only view of a binary RAG index, either mapped from a file or held in
+// memory after building it from JSON. Nothing is parsed on open: the entry
+// texts, the sorted term dictionary and the postings are used where they lie,
+// after one pass that checks every offset and posting is in range.
+//
+// Layout, all sections 8-byte aligned and in native byte order:
+//   header     magic, version, counts, field boosts, section offsets
+//   entries    per entry: offset and length of id, title and content in the text blob
+//   terms      per term, sorted by text: offset and length in the text blob, IDF,
+//              highest posting weight
+//   postings   offsets (terms + 1), entry indices and BM25 weights, term by term
+//              and in entry order within a term
+//   text       entry and term strings back to back
+class RAGIndex {
+public:
+    RAGIndex() = default;
+    ~RAGIndex();
+
+    RAGIndex(const RAGIndex&) = delete;
+    RAGIndex& operator=(const RAGIndex&) = delete;
+
+    // Map an index file built by BuildRAGIndex
+    bool Open(const std::string& filePath, std::string& error);
+
+    // Take over an index built in memory
+    bool Load(std::vector<char> buffer, std::string& error);
+
+    void Close();
+
+    bool IsOpen() const { return m_header != nullptr; }
+
+    uint32_t EntryCount() const;
+    uint32_t TermCount() const;
+    RAGFieldBoosts Boosts() const;
+
+    std::string_view EntryId(uint32_t entryIndex) const;
+    std::string_view EntryTitle(uint32_t entryIndex) const;
+    std::string_view EntryContent(uint32_t entryIndex) const;
+
+    // Look up a preprocessed token in the term dictionary
+    bool FindTerm(std::string_view term, uint32_t& termId) const;
+
+    float TermIdf(uint32_t termId) const;
+    float TermMaxWeight(uint32_t termId) const;
+
+    // Up to maxResults entries scoring at least threshold, best first. Scratch
+    // space is per thread, so concurrent searches are safe.
+    std::vector<RAGSearchHit> Search(const std::string& query, uint32_t maxResults, float threshold) const;
+
+    // Term t's postings are [PostingOffsets()[t], PostingOffsets()[t + 1])
+    const uint32_t* PostingOffsets() const { return m_postingOffsets; }
+    const uint32_t* PostingEntries() const { return m_postingEntries; }
+    const float* PostingWeights() const { return m_postingWeights; }
+
+private:
+    // Check the header, section bounds, tables and postings and set up the
+    // section pointers
+    bool Attach(const char* data, size_t size, std::string& error);
+
+    std::string_view Text(uint32_t offset, uint32_t length) const;
+
+    std::vector<char> m_buffer;             // backing store of an in-memory index
+    void* m_mapping = nullptr;              // backing store of a mapped index
+    size_t m_mappingSize = 0;
+
+    const RAGIndexHeader* m_header = nullptr;
+    const RAGIndexEntry* m_entries = nullptr;
+    const RAGIndexTerm* m_terms = nullptr;
+    const uint32_t* m_postingOffsets = nullptr;
+    const uint32_t* m_postingEntries = nullptr;
+    const float* m_postingWeights = nullptr;
+    const char* m_text = nullptr;
+};
+
+#endif // MOD_OLLAMA_CHAT_RAG_INDEX_H
@@ -14,6 +14,8 @@
 #include "mod-ollama-chat_api.h"
 #include "mod-ollama-chat_personality.h"
 #include "mod-ollama-chat-utilities.h"
+#include "mod-ollama-chat_presence.h"
+#include "mod-ollama-chat_outbox.h"
 #include "GridNotifiersImpl.h"
 #include "CellImpl.h"
 #include "Map.h"
@@ -77,6 +79,187 @@ void OllamaBotRandomChatter::OnUpdate(uint32 diff)
     }
 }
 
+// Outbox handler: says a random chatter line in guild, party, Say or General,
+// wherever a real player can still hear it.
+static void DeliverRandomReply(Player* bot, const OllamaReply& reply)
+{
+    PlayerbotAI* botAI = PlayerbotsMgr::instance().GetPlayerbotAI(bot);
+    if (!botAI) return;
+
+    // Guild-based random chatter goes to guild chat
+    if (reply.guild && bot->GetGuild())
+    {
+        // Check if guild chat is disabled
+        if (g_DisableForGuild)
+        {
+            if (g_DebugEnabled)
+                LOG_INFO("server.loading", "[Ollama Chat] Guild random chatter skipped (guild channels disabled)");
+            return;
+        }
+        
+        // Verify there are still real players in the guild
+        if (g_PresenceIndex.HasRealPlayerInGuild(bot->GetGuildId()))
+        {
+            if (g_DebugEnabled)
+                LOG_INFO("server.loading", "[Ollama Chat] Bot Guild-Based Random Chatter: {}", reply.text);
+            botAI->SayToGuild(reply.text);
+            ProcessBotChatMessage(bot, reply.text, SRC_GUILD_LOCAL, nullptr);
+        }
+        else if (g_DebugEnabled)
+        {
+            LOG_INFO("server.loading", "[Ollama Chat] Bot {} skipping guild random chatter (no real players in guild anymore)", bot->GetName());
+        }
+    }
+    else if (bot->GetGroup())
+    {
+        // Check if party chat is disabled
+        if (g_DisableForParty)
+        {
+            if (g_DebugEnabled)
+                LOG_INFO("server.loading", "[Ollama Chat] Party random chatter skipped (party channels disabled)");
+            return;
+        }
+        
+        if (g_DebugEnabled)
+            LOG_INFO("server.loading", "[Ollama Chat] Bot Random Chatter Party: {}", reply.text);
+        botAI->SayToParty(reply.text);
+        ProcessBotChatMessage(bot, reply.text, SRC_PARTY_LOCAL, nullptr);
+    }
+    else
+    {
+        // For bots not in a party, check if any real player is within Say distance
+        bool realPlayerInSayDistance = false;
+        if (bot->IsInWorld())
+        {
+            for (auto const& pair : ObjectAccessor::GetPlayers())
+            {
+                Player* player = pair.second;
+                if (!player || !player->IsInWorld())
+                    continue;
+                    
+                if (HasPlayerbotAI(player))
+                    continue;
+                    
+                if (bot->GetDistance(player) <= g_SayDistance)
+                {
+                    realPlayerInSayDistance = true;
+                    break;
+                }
+            }
+        }
+        
+        // Build channel list - only include channels with real players
+        std::vector<std::string> channels;
+        
+        // Check if any real player is in the General channel (same zone and faction)
+        bool realPlayerInGeneral = false;
+        if (!g_DisableForCustomChannels)
+        {
+            for (auto const& pair : ObjectAccessor::GetPlayers())
+            {
+                Player* player = pair.second;
+                if (!player || !player->IsInWorld())
+                    continue;
+                if (HasPlayerbotAI(player))
+                    continue;
+                // General channel is faction and zone specific
+                if (player->GetTeamId() == bot->GetTeamId() && 
+                    player->GetZoneId() == bot->GetZoneId())
+                {
+                    realPlayerInGeneral = true;
+                    break;
+                }
+            }
+            
+            if (realPlayerInGeneral)
+            {
+                channels.push_back("General");
+                if (g_DebugEnabled)
+                    LOG_INFO("server.loading", "[Ollama Chat] Bot {} adding General to random chatter options (real player in channel)", bot->GetName());
+            }
+            else if (g_DebugEnabled)
+            {
+                LOG_INFO("server.loading", "[Ollama Chat] Bot {} NOT adding General to random chatter (no real player in channel)", bot->GetName());
+            }
+        }
+        
+        // Only add Say if not disabled and real player is close enough
+        if (!g_DisableForSayYell && realPlayerInSayDistance)
+        {
+            channels.push_back("Say");
+            if (g_DebugEnabled)
+                LOG_INFO("server.loading", "[Ollama Chat] Bot {} adding Say to random chatter options (real player within {} yards)", bot->GetName(), g_SayDistance);
+        }
+        else if (g_DebugEnabled)
+        {
+            if (g_DisableForSayYell)
+                LOG_INFO("server.loading", "[Ollama Chat] Bot {} NOT adding Say to random chatter (Say/Yell disabled)", bot->GetName());
+            else
+                LOG_INFO("server.loading", "[Ollama Chat] Bot {} NOT adding Say to random chatter (no real player within {} yards)", bot->GetName(), g_SayDistance);
+        }
+        
+        // If no channels are available, skip random chatter
+        if (channels.empty())
+        {
+            if (g_DebugEnabled)
+                LOG_INFO("server.loading", "[Ollama Chat] Bot {} skipping random chatter (all available channels disabled)", bot->GetName());
+            return;
+        }
+        
+        // Pick random channel
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<size_t> dist(0, channels.size() - 1);
+        std::string selectedChannel = channels[dist(gen)];
+        
+        if (selectedChannel == "Say") {
+            if (g_DebugEnabled)
+                LOG_INFO("server.loading", "[Ollama Chat] Bot {} Random Chatter Say (real player within {} yards): {}", bot->GetName(), g_SayDistance, reply.text);
+            botAI->Say(reply.text);
+            ProcessBotChatMessage(bot, reply.text, SRC_SAY_LOCAL, nullptr);
+        } else if (selectedChannel == "General") {
+            if (g_DebugEnabled)
+                LOG_INFO("server.loading", "[Ollama Chat] Bot {} Random Chatter General: {}", bot->GetName(), reply.text);
+            
+            // Look up the General channel BEFORE sending
+            Channel* generalChannel = nullptr;
+            ChannelMgr* cMgr = ChannelMgr::forTeam(bot->GetTeamId());
+            if (cMgr)
+            {
+                generalChannel = cMgr->GetChannel("General", bot);
+            }
+            
+            // Use playerbots' SayToChannel method - it handles channel lookup internally
+            bool sent = botAI->SayToChannel(reply.text, ChatChannelId::GENERAL);
+            if (g_DebugEnabled)
+                LOG_INFO("server.loading", "[Ollama Chat] Bot {} SayToChannel result: {}", bot->GetName(), sent ? "success" : "failed, using Say fallback");
+            
+            if (sent && generalChannel)
+            {
+                ProcessBotChatMessage(bot, reply.text, SRC_GENERAL_LOCAL, generalChannel);
+            }
+            else if (sent && !generalChannel && g_DebugEnabled)
+            {
+                LOG_ERROR("server.loading", "[Ollama Chat] Bot {} sent to General but could not find channel for triggering replies", bot->GetName());
+            }
+            
+            if (!sent)
+            {
+                // Fallback to Say if channel message failed (and real player is close enough)
+                if (realPlayerInSayDistance)
+                {
+                    botAI->Say(reply.text);
+                    ProcessBotChatMessage(bot, reply.text, SRC_SAY_LOCAL, nullptr);
+                }
+                else if (g_DebugEnabled)
+                {
+                    LOG_INFO("server.loading", "[Ollama Chat] Bot {} cannot send to General and no real player in Say range, message lost", bot->GetName());
+                }
+            }
+        }
+    }
+}
+
 void OllamaBotRandomChatter::HandleRandomChatter()
 {
     auto const& allPlayers = ObjectAccessor::GetPlayers();
@@ -86,7 +269,7 @@ void OllamaBotRandomChatter::HandleRandomChatter()
     {
         Player* player = itr.second;
         if (!player->IsInWorld()) continue;
-        if (!PlayerbotsMgr::instance().GetPlayerbotAI(player))
+        if (!HasPlayerbotAI(player))
             realPlayers.push_back(player);
     }
 
@@ -110,7 +293,7 @@ void OllamaBotRandomChatter::HandleRandomChatter()
                 Player* player = pair.second;
                 if (!player || !player->IsInWorld())
                     continue;
-                if (PlayerbotsMgr::instance().GetPlayerbotAI(player))
+                if (HasPlayerbotAI(player))
                     continue;
                 if (player->GetGuild() && player->GetGuild()->GetId() == guild->GetId())
                 {
@@ -431,7 +614,7 @@ void OllamaBotRandomChatter::HandleRandomChatter()
                     Player* player = pair.second;
                     if (!player || !player->IsInWorld())
                         continue;
-                    if (PlayerbotsMgr::instance().GetPlayerbotAI(player))
+                    if (HasPlayerbotAI(player))
                         continue;
                     if (player->GetGuild() && player->GetGuild()->GetId() == guild->GetId())
                     {
@@ -627,7 +810,7 @@ void OllamaBotRandomChatter::HandleRandomChatter()
                         Player* player = pair.second;
                         if (!player || !player->IsInWorld())
                             continue;
-                        if (PlayerbotsMgr::instance().GetPlayerbotAI(player))
+                        if (HasPlayerbotAI(player))
                             continue;
                         if (player->GetGuild() && player->GetGuild()->GetId() == guild->GetId())
                         {
@@ -659,7 +842,7 @@ void OllamaBotRandomChatter::HandleRandomChatter()
                         Player* player = pair.second;
                         if (!player || !player->IsInWorld())
                             continue;
-                        if (PlayerbotsMgr::instance().GetPlayerbotAI(player))
+                        if (HasPlayerbotAI(player))
                             continue;
                         if (bot->GetDistance(player) <= g_SayDistance)
                         {
@@ -677,7 +860,7 @@ void OllamaBotRandomChatter::HandleRandomChatter()
                         Player* player = pair.second;
                         if (!player || !player->IsInWorld())
                             continue;
-                        if (PlayerbotsMgr::instance().GetPlayerbotAI(player))
+                        if (HasPlayerbotAI(player))
                             continue;
                         // General channel is faction and zone specific
                         if (player->GetTeamId() == bot->GetTeamId() && 
@@ -707,13 +890,14 @@ void OllamaBotRandomChatter::HandleRandomChatter()
 
             uint64_t botGuid = bot->GetGUID().GetRawValue();
 
-            std::thread([botGuid, prompt, isGuildComment]() {
-                try {
-                    Player* botPtr = ObjectAccessor::FindPlayer(ObjectGuid(botGuid));
-                    if (!botPtr) return;
-                    
-                    // Generate response from LLM
-                    std::string response = QueryOllamaAPI(prompt);
+            OllamaRequest request;
+            request.prompt = prompt;
+            request.purpose = isGuildComment ? QueryPurpose::Guild : QueryPurpose::Random;
+
+            // Generate response from LLM through the shared query queue; the
+            // reply is handled on the query worker
+            SubmitQueryAsync(std::move(request), QueryPriority::Ambient,
+                [botGuid, isGuildComment](std::string response) {
                     if (response.empty())
                     {
                         if (g_DebugEnabled)
@@ -721,222 +905,25 @@ void OllamaBotRandomChatter::HandleRandomChatter()
                         return;
                     }
                     
-                    botPtr = ObjectAccessor::FindPlayer(ObjectGuid(botGuid));
-                    if (!botPtr) return;
-                    PlayerbotAI* botAI = PlayerbotsMgr::instance().GetPlayerbotAI(botPtr);
-                    if (!botAI) return;
-                    
-                    // Simulate typing delay if enabled
+                    // The world thread re-checks who can hear it and sends it
+                    OllamaReply reply;
+
+                    // Simulate typing delay if enabled; the outbox holds the reply until then
                     if (g_EnableTypingSimulation)
                     {
-                        uint32_t delay = g_TypingSimulationBaseDelay + (response.length() * g_TypingSimulationDelayPerChar);
+                        auto delay = GetTypingDelay(response.length());
                         if (g_DebugEnabled)
                             LOG_INFO("server.loading", "[OllamaChat] Bot simulating typing delay: {}ms for {} characters", 
-                                     delay, response.length());
-                        std::this_thread::sleep_for(std::chrono::milliseconds(delay));
-                        
-                        // Reacquire pointers after delay
-                        botPtr = ObjectAccessor::FindPlayer(ObjectGuid(botGuid));
-                        if (!botPtr) return;
-                        botAI = PlayerbotsMgr::instance().GetPlayerbotAI(botPtr);
-                        if (!botAI) return;
-                    }
-                    
-                    // Guild-based random chatter goes to guild chat
-                    if (isGuildComment && botPtr->GetGuild())
-                    {
-                        // Check if guild chat is disabled
-                        if (g_DisableForGuild)
-                        {
-                            if (g_DebugEnabled)
-                                LOG_INFO("server.loading", "[Ollama Chat] Guild random chatter skipped (guild channels disabled)");
-                            return;
-                        }
-                        
-                        // Verify there are still real players in the guild
-                        bool hasRealPlayerInGuild = false;
-                        Guild* guild = botPtr->GetGuild();
-                        for (auto const& pair : ObjectAccessor::GetPlayers())
-                        {
-                            Player* player = pair.second;
-                            if (!player || !player->IsInWorld())
-                                continue;
-                            if (PlayerbotsMgr::instance().GetPlayerbotAI(player))
-                                continue;
-                            if (player->GetGuild() && player->GetGuild()->GetId() == guild->GetId())
-                            {
-                                hasRealPlayerInGuild = true;
-                                break;
-                            }
-                        }
-                        
-                        if (hasRealPlayerInGuild)
-                        {
-                            if (g_DebugEnabled)
-                                LOG_INFO("server.loading", "[Ollama Chat] Bot Guild-Based Random Chatter: {}", response);
-                            botAI->SayToGuild(response);
-                            ProcessBotChatMessage(botPtr, response, SRC_GUILD_LOCAL, nullptr);
-                        }
-                        else if (g_DebugEnabled)
-                        {
-                            LOG_INFO("server.loading", "[Ollama Chat] Bot {} skipping guild random chatter (no real players in guild anymore)", botPtr->GetName());
-                        }
-                    }
-                    else if (botPtr->GetGroup())
-                    {
-                        // Check if party chat is disabled
-                        if (g_DisableForParty)
-                        {
-                            if (g_DebugEnabled)
-                                LOG_INFO("server.loading", "[Ollama Chat] Party random chatter skipped (party channels disabled)");
-                            return;
-                        }
-                        
-                        if (g_DebugEnabled)
-                            LOG_INFO("server.loading", "[Ollama Chat] Bot Random Chatter Party: {}", response);
-                        botAI->SayToParty(response);
-                        ProcessBotChatMessage(botPtr, response, SRC_PARTY_LOCAL, nullptr);
-                    }
-                    else
-                    {
-                        // For bots not in a party, check if any real player is within Say distance
-                        bool realPlayerInSayDistance = false;
-                        if (botPtr->IsInWorld())
-                        {
-                            for (auto const& pair : ObjectAccessor::GetPlayers())
-                            {
-                                Player* player = pair.second;
-                                if (!player || !player->IsInWorld())
-                                    continue;
-                                    
-                                if (PlayerbotsMgr::instance().GetPlayerbotAI(player))
-                                    continue;
-                                    
-                                if (botPtr->GetDistance(player) <= g_SayDistance)
-                                {
-                                    realPlayerInSayDistance = true;
-                                    break;
-                                }
-                            }
-                        }
-                        
-                        // Build channel list - only include channels with real players
-                        std::vector<std::string> channels;
-                        
-                        // Check if any real player is in the General channel (same zone and faction)
-                        bool realPlayerInGeneral = false;
-                        if (!g_DisableForCustomChannels)
-                        {
-                            for (auto const& pair : ObjectAccessor::GetPlayers())
-                            {
-                                Player* player = pair.second;
-                                if (!player || !player->IsInWorld())
-                                    continue;
-                                if (PlayerbotsMgr::instance().GetPlayerbotAI(player))
-                                    continue;
-                                // General channel is faction and zone specific
-                                if (player->GetTeamId() == botPtr->GetTeamId() && 
-                                    player->GetZoneId() == botPtr->GetZoneId())
-                                {
-                                    realPlayerInGeneral = true;
-                                    break;
-                                }
-                            }
-                            
-                            if (realPlayerInGeneral)
-                            {
-                                channels.push_back("General");
-                                if (g_DebugEnabled)
-                                    LOG_INFO("server.loading", "[Ollama Chat] Bot {} adding General to random chatter options (real player in channel)", botPtr->GetName());
-                            }
-                            else if (g_DebugEnabled)
-                            {
-                                LOG_INFO("server.loading", "[Ollama Chat] Bot {} NOT adding General to random chatter (no real player in channel)", botPtr->GetName());
-                            }
-                        }
-                        
-                        // Only add Say if not disabled and real player is close enough
-                        if (!g_DisableForSayYell && realPlayerInSayDistance)
-                        {
-                            channels.push_back("Say");
-                            if (g_DebugEnabled)
-                                LOG_INFO("server.loading", "[Ollama Chat] Bot {} adding Say to random chatter options (real player within {} yards)", botPtr->GetName(), g_SayDistance);
-                        }
-                        else if (g_DebugEnabled)
-                        {
-                            if (g_DisableForSayYell)
-                                LOG_INFO("server.loading", "[Ollama Chat] Bot {} NOT adding Say to random chatter (Say/Yell disabled)", botPtr->GetName());
-                            else
-                                LOG_INFO("server.loading", "[Ollama Chat] Bot {} NOT adding Say to random chatter (no real player within {} yards)", botPtr->GetName(), g_SayDistance);
-                        }
-                        
-                        // If no channels are available, skip random chatter
-                        if (channels.empty())
-                        {
-                            if (g_DebugEnabled)
-                                LOG_INFO("server.loading", "[Ollama Chat] Bot {} skipping random chatter (all available channels disabled)", botPtr->GetName());
-                            return;
-                        }
-                        
-                        // Pick random channel
-                        std::random_device rd;
-                        std::mt19937 gen(rd());
-                        std::uniform_int_distribution<size_t> dist(0, channels.size() - 1);
-                        std::string selectedChannel = channels[dist(gen)];
-                        
-                        if (selectedChannel == "Say") {
-                            if (g_DebugEnabled)
-                                LOG_INFO("server.loading", "[Ollama Chat] Bot {} Random Chatter Say (real player within {} yards): {}", botPtr->GetName(), g_SayDistance, response);
-                            botAI->Say(response);
-                            ProcessBotChatMessage(botPtr, response, SRC_SAY_LOCAL, nullptr);
-                        } else if (selectedChannel == "General") {
-                            if (g_DebugEnabled)
-                                LOG_INFO("server.loading", "[Ollama Chat] Bot {} Random Chatter General: {}", botPtr->GetName(), response);
-                            
-                            // Look up the General channel BEFORE sending
-                            Channel* generalChannel = nullptr;
-                            ChannelMgr* cMgr = ChannelMgr::forTeam(botPtr->GetTeamId());
-                            if (cMgr)
-                            {
-                                generalChannel = cMgr->GetChannel("General", botPtr);
-                            }
-                            
-                            // Use playerbots' SayToChannel method - it handles channel lookup internally
-                            bool sent = botAI->SayToChannel(response, ChatChannelId::GENERAL);
-                            if (g_DebugEnabled)
-                                LOG_INFO("server.loading", "[Ollama Chat] Bot {} SayToChannel result: {}", botPtr->GetName(), sent ? "success" : "failed, using Say fallback");
-                            
-                            if (sent && generalChannel)
-                            {
-                                ProcessBotChatMessage(botPtr, response, SRC_GENERAL_LOCAL, generalChannel);
-                            }
-                            else if (sent && !generalChannel && g_DebugEnabled)
-                            {
-                                LOG_ERROR("server.loading", "[Ollama Chat] Bot {} sent to General but could not find channel for triggering replies", botPtr->GetName());
-                            }
-                            
-                            if (!sent)
-                            {
-                                // Fallback to Say if channel message failed (and real player is close enough)
-                                if (realPlayerInSayDistance)
-                                {
-                                    botAI->Say(response);
-                                    ProcessBotChatMessage(botPtr, response, SRC_SAY_LOCAL, nullptr);
-                                }
-                                else if (g_DebugEnabled)
-                                {
-                                    LOG_INFO("server.loading", "[Ollama Chat] Bot {} cannot send to General and no real player in Say range, message lost", botPtr->GetName());
-                                }
-                            }
-                        }
+                                     delay.count(), response.length());
+                        reply.notBefore = std::chrono::steady_clock::now() + delay;
                     }
-                } catch (const std::exception& e) {
-                    LOG_ERROR("server.loading", "[Ollama Chat] Exception in random chatter thread: {}", e.what());
-                } catch (...) {
-                    LOG_ERROR("server.loading", "[Ollama Chat] Unknown exception in random chatter thread");
-                }
-            }).detach();
 
+                    reply.deliver = DeliverRandomReply;
+                    reply.botGuid = botGuid;
+                    reply.text = std::move(response);
+                    reply.guild = isGuildComment;
+                    g_ReplyOutbox.Push(std::move(reply));
+                });
 
             nextRandomChatTime[guid] = now + urand(g_MinRandomInterval, g_MaxRandomInterval);
     }
@@ -48,22 +48,21 @@ void SetBotPlayerSentiment(uint64_t botGuid, uint64_t playerGuid, float sentimen
     }
 }
 
-float AnalyzeMessageSentiment(const std::string& message)
+static std::string BuildSentimentPrompt(const std::string& message)
 {
-    if (!g_EnableSentimentTracking || message.empty())
-        return 0.0f;
-
-    // Format the sentiment analysis prompt
-    std::string prompt = SafeFormat(g_SentimentAnalysisPrompt, fmt::arg("message", message));
+    // Format the sentiment analysis prompt; this runs on query workers, so the
+    // template comes from the published config rather than the global
+    std::string prompt = SafeFormat(GetOllamaPromptConfig()->sentimentAnalysisPrompt, fmt::arg("message", message));
     
     if (g_DebugEnabled)
     {
         LOG_INFO("server.loading", "[OllamaChat] Sentiment analysis prompt: {}", prompt);
     }
-    
-    // Query the LLM for sentiment analysis
-    std::string response = QueryOllamaAPI(prompt);
-    
+    return prompt;
+}
+
+static float ParseSentimentResponse(const std::string& response)
+{
     if (response.empty())
     {
         if (g_DebugEnabled)
@@ -101,26 +100,37 @@ void UpdateBotPlayerSentiment(Player* bot, Player* player, const std::string& me
     if (!g_EnableSentimentTracking || !bot || !player)
         return;
 
-    uint64_t botGuid = bot->GetGUID().GetRawValue();
-    uint64_t playerGuid = player->GetGUID().GetRawValue();
-    
-    // Get current sentiment
-    float currentSentiment = GetBotPlayerSentiment(botGuid, playerGuid);
-    
-    // Analyze the message sentiment
-    float adjustment = AnalyzeMessageSentiment(message);
-    
-    // Apply the adjustment
-    float newSentiment = currentSentiment + adjustment;
-    
-    // Set the updated sentiment
-    SetBotPlayerSentiment(botGuid, playerGuid, newSentiment);
-    
-    if (g_DebugEnabled && adjustment != 0.0f)
-    {
-        LOG_INFO("server.loading", "[OllamaChat] Updated sentiment: {} -> {} ({:+.2f}) for bot {} and player {}", 
-                 currentSentiment, newSentiment, adjustment, bot->GetName(), player->GetName());
-    }
+    UpdateBotPlayerSentiment(bot->GetGUID().GetRawValue(), player->GetGUID().GetRawValue(), message);
+}
+
+void UpdateBotPlayerSentiment(uint64_t botGuid, uint64_t playerGuid, const std::string& message)
+{
+    if (!g_EnableSentimentTracking || message.empty())
+        return;
+
+    // Queue the analysis as a background query; the adjustment is applied by the
+    // worker once it answers, so nothing waits for it.
+    OllamaRequest request;
+    request.prompt = BuildSentimentPrompt(message);
+    request.purpose = QueryPurpose::Sentiment;
+    SubmitQueryAsync(std::move(request), QueryPriority::Background,
+        [botGuid, playerGuid](std::string response) {
+            float adjustment = ParseSentimentResponse(response);
+            if (adjustment == 0.0f)
+                return;
+
+            // Read the current sentiment only now, so updates that finished in
+            // the meantime are not overwritten
+            float currentSentiment = GetBotPlayerSentiment(botGuid, playerGuid);
+            float newSentiment = currentSentiment + adjustment;
+            SetBotPlayerSentiment(botGuid, playerGuid, newSentiment);
+            
+            if (g_DebugEnabled)
+            {
+                LOG_INFO("server.loading", "[OllamaChat] Updated sentiment: {} -> {} ({:+.2f}) for bot {} and player {}", 
+                         currentSentiment, newSentiment, adjustment, botGuid, playerGuid);
+            }
+        });
 }
 
 std::string GetSentimentPromptAddition(Player* bot, Player* player)
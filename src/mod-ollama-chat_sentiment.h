@@ -26,20 +26,22 @@ float GetBotPlayerSentiment(uint64_t botGuid, uint64_t playerGuid);
 void SetBotPlayerSentiment(uint64_t botGuid, uint64_t playerGuid, float sentimentValue);
 
 /**
- * Analyze the sentiment of a message using LLM
- * @param message The message to analyze
- * @return Sentiment adjustment (-1.0 to 1.0)
- */
-float AnalyzeMessageSentiment(const std::string& message);
-
-/**
- * Update sentiment based on a player's message to a bot
+ * Update sentiment based on a player's message to a bot. The analysis is
+ * queued as a background query and applied when it completes.
  * @param bot The bot receiving the message
  * @param player The player sending the message
  * @param message The message content
  */
 void UpdateBotPlayerSentiment(Player* bot, Player* player, const std::string& message);
 
+/**
+ * Same as above by GUID; safe to call from a query worker
+ * @param botGuid The bot receiving the message
+ * @param playerGuid The player sending the message
+ * @param message The message content
+ */
+void UpdateBotPlayerSentiment(uint64_t botGuid, uint64_t playerGuid, const std::string& message);
+
 /**
  * Get sentiment prompt addition for including in bot responses
  * @param bot The bot